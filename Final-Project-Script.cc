@@ -28,6 +28,24 @@
 #include "ns3/network-module.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "cached-propagation-loss-model.h"
+#include "goodput-convergence.h"
+#include "goodput-monitor.h"
+#include "hex-topology.h"
+#include "lte-binary-traces.h"
+#include "lte-interference-culling.h"
+#include "replication-stats.h"
+#include "result-store.h"
+#include "sim-process-pool.h"
+#include "steady-state-goodput.h"
+#include "timed-ff-mac-scheduler.h"
 
 using namespace ns3;
 using namespace std;
@@ -38,38 +56,147 @@ using namespace std;
  * It also starts another flow between each UE pair.
  */
 
-int
-main (int argc, char *argv[])
+/// Parameters of one run of the FFR scenario
+struct ScenarioConfig
 {
-  RngSeedManager::SetSeed(42);
-  double simTime = 4.0;
-  double distance = 1000.0;
-  Time interPacketInterval = MilliSeconds (10);
-  uint16_t numCenterUes = 1;
-  uint16_t numEdgeUes = 1;
-  uint16_t numRandomUes = 1;
-  string algo = "NoOp";
+  double simTime;
+  double distance;
+  Time interPacketInterval;
+  uint16_t numCenterUes;
+  uint16_t numEdgeUes;
+  uint16_t numRandomUes;
+  string algo;
+  uint32_t seed;
+  bool enableTraces;
+  bool binaryTraces; ///< write the traces with LteBinaryTraceHelper instead
+  bool compressTraces; ///< compress the binary traces with zstd
+  Time goodputWindow; ///< window of the goodput series, zero disables it
+  string goodputOutput; ///< CSV file receiving the goodput series
+  uint16_t hexRings; ///< rings of a hexagonal layout, 0 for the original three cells
+  bool wrapAround; ///< wrap the interference around the hexagonal layout
+  bool pathlossCache; ///< cache the pathloss with CachedPropagationLossModel
+  double cullingMarginDb; ///< drop signals this far below noise, negative disables culling
+  string scheduler; ///< type of the FF MAC scheduler
+  bool schedulerCost; ///< measure the scheduler with TimedFfMacScheduler
+  double stopHalfWidth; ///< stop once the class goodput CIs are this narrow relative to the mean, 0 disables it
+  Time stopBatch; ///< batch length of the early stopping
+  uint32_t stopMinBatches; ///< batches needed before stopping early
+  double confidence; ///< level of the confidence intervals
+  bool warmupDetection; ///< measure every flow from the end of its MSER-5 warm-up instead of from 0.5 s
+  Time warmupWindow; ///< window of the throughput series of the warm-up detection
+  uint32_t maxPackets; ///< packets sent by every client, 0 for as many as simTime allows
+};
 
-  // Command line arguments
-  CommandLine cmd (__FILE__);
-  cmd.AddValue ("numCenterUes", "Number of center UEs per cell", numCenterUes);
-  cmd.AddValue ("numEdgeUes", "Number of edge UEs per cell", numEdgeUes);
-  cmd.AddValue ("numRandomUes", "Number of random UEs per cell", numRandomUes);
-  cmd.AddValue ("simTime", "Total duration of the simulation", simTime);
-  cmd.AddValue ("distance", "Distance between eNBs [m]", distance);
-  cmd.AddValue ("interPacketInterval", "Inter packet interval", interPacketInterval);
-  cmd.AddValue ("algo", "Algorithim", algo);
-  cmd.Parse (argc, argv);
+/// Uplink goodput of one flow, as measured by its PacketSink
+struct FlowGoodput
+{
+  uint32_t enb;
+  string ueClass; ///< "Center", "Edge" or "Random"
+  uint32_t flow;  ///< index of the flow within its class and eNB
+  double goodput; ///< [bit/s]
+  double warmupEnd; ///< start of the goodput measurement [s]
+  double delay; ///< mean one-way delay of the received packets, 0 without packets [s]
+};
 
-  ConfigStore inputConfig;
-  inputConfig.ConfigureDefaults ();
+/// Number of cells of the scenario described by config
+static uint32_t
+GetNumberOfCells (const ScenarioConfig &config)
+{
+  return config.hexRings == 0 ? 3 : HexTopology (config.hexRings, config.distance).GetNCells ();
+}
 
-  // parse again so you can override default values from the command line
-  cmd.Parse(argc, argv);
+/// Traffic and seed of one child of a warm-started run
+struct WarmStartVariant
+{
+  uint32_t run; ///< run number of the random number generator
+  Time interPacketInterval;
+};
+
+/// Write goodputs as text, one "enb class flow goodput warmupEnd delay" line per flow
+static void
+WriteGoodputs (ostream &out, const vector<FlowGoodput> &results)
+{
+  out.precision (17);
+  for (size_t k = 0; k < results.size (); ++k)
+    {
+      out << results[k].enb << " " << results[k].ueClass << " "
+          << results[k].flow << " " << results[k].goodput << " " << results[k].warmupEnd
+          << " " << results[k].delay << "\n";
+    }
+}
+
+/// Parse the output of WriteGoodputs
+static vector<FlowGoodput>
+ReadGoodputs (const string &text)
+{
+  vector<FlowGoodput> results;
+  istringstream is (text);
+  FlowGoodput g;
+  while (is >> g.enb >> g.ueClass >> g.flow >> g.goodput >> g.warmupEnd >> g.delay)
+    {
+      results.push_back (g);
+    }
+  return results;
+}
+
+/// Size of the uplink UDP packets, SeqTsHeader included [bytes]
+static const uint32_t UL_PACKET_SIZE = 1024;
+
+/// One-way delay of the packets received by a sink
+struct DelayStats
+{
+  double sum; ///< [s]
+  uint64_t packets;
+};
+
+/// Add the delay of packet, a UdpClient packet, to stats
+static void
+RecordDelay (DelayStats *stats, Ptr<const Packet> packet, const Address &from)
+{
+  SeqTsHeader seqTs;
+  packet->PeekHeader (seqTs);
+  stats->sum += (Simulator::Now () - seqTs.GetTs ()).GetSeconds ();
+  ++stats->packets;
+}
+
+/**
+ * Build and run the scenario described by config.
+ *
+ * Without variants the scenario simply runs to simTime, or until the
+ * class goodputs have converged if stopHalfWidth is set.  With variants it
+ * is built and warmed up once, up to the start of the applications, and
+ * then forked into one child process per variant, on at most jobs workers
+ * (0 for one per CPU).  Each child inherits the warmed-up simulation
+ * copy-on-write, applies its seed run and inter-packet interval, and runs
+ * to simTime.
+ * \return the goodput of every flow, ordered by eNB, then class, then flow;
+ *         one result per variant, or a single one without variants
+ */
+static vector<vector<FlowGoodput> >
+RunScenario (const ScenarioConfig &config, const vector<WarmStartVariant> &variants, unsigned jobs)
+{
+  double simTime = config.simTime;
+  double distance = config.distance;
+  Time interPacketInterval = config.interPacketInterval;
+  uint16_t numCenterUes = config.numCenterUes;
+  uint16_t numEdgeUes = config.numEdgeUes;
+  uint16_t numRandomUes = config.numRandomUes;
+  string algo = config.algo;
+
+  RngSeedManager::SetSeed (config.seed);
 
   Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
   Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper> ();
   lteHelper->SetEpcHelper (epcHelper);
+  if (config.schedulerCost)
+    {
+      lteHelper->SetSchedulerType ("ns3::TimedFfMacScheduler");
+      lteHelper->SetSchedulerAttribute ("SchedulerType", StringValue (config.scheduler));
+    }
+  else
+    {
+      lteHelper->SetSchedulerType (config.scheduler);
+    }
 
   Ptr<Node> pgw = epcHelper->GetPgwNode ();
 
@@ -97,74 +224,110 @@ main (int argc, char *argv[])
   remoteHostStaticRouting->AddNetworkRouteTo (Ipv4Address ("7.0.0.0"), Ipv4Mask ("255.0.0.0"), 1);
 
   // Create Nodes: eNodeB and UE
+  // Every cell has a site, a reuse-3 FrCellTypeId and a box for its random UEs
+  vector<Vector> sites;
+  vector<uint8_t> cellTypes;
+  vector<Box> bounds;
+  HexTopology hex (config.hexRings, distance);
+  if (config.hexRings == 0)
+    {
+      /*   the topology is the following:
+      *                 eNB3
+      *                /     \
+      *               /       \
+      *              /         \
+      *             /           \
+      *   distance /             \ distance
+      *           /      UEs      \
+      *          /                 \
+      *         /                   \
+      *        /                     \
+      *       /                       \
+      *   eNB1-------------------------eNB2
+      *                  distance
+      */
+      sites.push_back (Vector (0.0, 0.0, 0.0));                           // eNB1
+      sites.push_back (Vector (distance, 0.0, 0.0));                      // eNB2
+      sites.push_back (Vector (distance * 0.5, -distance * 0.866, 0.0));  // eNB3
+      for (uint8_t t = 1; t <= 3; ++t)
+        {
+          cellTypes.push_back (t);
+        }
+      bounds.push_back (Box (-distance * 0.5, distance * 0.5, -distance * 0.5, distance * 0.5, 1.5, 1.5));
+      bounds.push_back (Box (distance * 0.5, distance * 1.5, -distance * 0.5, distance * 0.5, 1.5, 1.5));
+      bounds.push_back (Box (distance * 0.28867, distance * 0.866, -distance * 1.5, -distance * 0.5, 1.5, 1.5));
+    }
+  else
+    {
+      for (uint32_t i = 0; i < hex.GetNCells (); ++i)
+        {
+          sites.push_back (hex.GetSitePosition (i));
+          cellTypes.push_back (hex.GetCellTypeId (i));
+          bounds.push_back (hex.GetCellBounds (i, 1.5));
+        }
+    }
+  uint32_t nCells = sites.size ();
+
+  string pathlossType = "ns3::FriisPropagationLossModel";
+  if (config.hexRings > 0 && config.wrapAround)
+    {
+      Config::SetDefault ("ns3::HexWrapAroundPropagationLossModel::Rings", UintegerValue (config.hexRings));
+      Config::SetDefault ("ns3::HexWrapAroundPropagationLossModel::Distance", DoubleValue (distance));
+      pathlossType = "ns3::HexWrapAroundPropagationLossModel";
+    }
+  if (config.pathlossCache)
+    {
+      lteHelper->SetAttribute ("PathlossModel", StringValue ("ns3::CachedPropagationLossModel"));
+      lteHelper->SetPathlossModelAttribute ("ModelType", StringValue (pathlossType));
+    }
+  else
+    {
+      lteHelper->SetAttribute ("PathlossModel", StringValue (pathlossType));
+    }
+
   NodeContainer enbNodes;
   NodeContainer centerUeNodes;
   NodeContainer edgeUeNodes;
   NodeContainer randomUeNodes;
-  enbNodes.Create (3);
-  centerUeNodes.Create (numCenterUes * 3);
-  edgeUeNodes.Create (numEdgeUes * 3);
-  randomUeNodes.Create(numRandomUes * 3);
-
-  Box leftBound = Box (-distance * 0.5, distance * 0.5, -distance * 0.5, distance * 0.5, 1.5, 1.5);
-  Box rightBound = Box (distance * 0.5, distance * 1.5, -distance * 0.5, distance * 0.5, 1.5, 1.5);
-  Box topBound = Box (distance * 0.28867, distance * 0.866, -distance * 1.5, -distance * 0.5, 1.5, 1.5);
-
-  vector<Box> bounds;
-
-  bounds.push_back(leftBound);
-  bounds.push_back(rightBound);
-  bounds.push_back(topBound);
-  
-  /*   the topology is the following:
-  *                 eNB3
-  *                /     \
-  *               /       \
-  *              /         \
-  *             /           \
-  *   distance /             \ distance
-  *           /      UEs      \
-  *          /                 \
-  *         /                   \
-  *        /                     \
-  *       /                       \
-  *   eNB1-------------------------eNB2
-  *                  distance
-  */
+  enbNodes.Create (nCells);
+  centerUeNodes.Create (numCenterUes * nCells);
+  edgeUeNodes.Create (numEdgeUes * nCells);
+  randomUeNodes.Create(numRandomUes * nCells);
 
   // Install Mobility Model
   MobilityHelper mobility;
   mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
   
   Ptr<ListPositionAllocator> enbPositionAlloc = CreateObject<ListPositionAllocator> ();
-  enbPositionAlloc->Add (Vector (0.0, 0.0, 0.0));                       // eNB1
-  enbPositionAlloc->Add (Vector (distance, 0.0, 0.0));                 // eNB2
-  enbPositionAlloc->Add (Vector (distance * 0.5, -distance * 0.866, 0.0));   // eNB3
-  
+  for (uint32_t i = 0; i < nCells; i++) {
+    enbPositionAlloc->Add (sites[i]);
+  }
   mobility.SetPositionAllocator (enbPositionAlloc);
   mobility.Install (enbNodes);
  
+  // UE j of cell i is node i * numXxxUes + j of its class
   if (centerUeNodes.GetN() > 0) {
     Ptr<ListPositionAllocator> centerUePositionAlloc = CreateObject<ListPositionAllocator> ();
-    for (int i = 0; i < numCenterUes; i++) {
-      centerUePositionAlloc->Add (Vector (0.0, 0.0, 0.0));                               // centerUE1
-    }
-    for (int i = 0; i < numCenterUes; i++) {
-      centerUePositionAlloc->Add (Vector (distance, 0.0, 0.0));                         // centerUE2
-    }
-    for (int i = 0; i < numCenterUes; i++) {
-      centerUePositionAlloc->Add (Vector (distance * 0.5, -distance * 0.866, 0.0));      // centerUE3
+    for (uint32_t i = 0; i < nCells; i++) {
+      for (int j = 0; j < numCenterUes; j++) {
+        centerUePositionAlloc->Add (sites[i]);
+      }
     }
     mobility.SetPositionAllocator (centerUePositionAlloc);
     mobility.Install (centerUeNodes);
   }
 
   if (edgeUeNodes.GetN() > 0) {
+    // on the corners of the cell, where three cells meet
     Ptr<ListPositionAllocator> edgeUePositionAlloc = CreateObject<ListPositionAllocator> ();
-    for (int i = 0; i < numEdgeUes; i++) {
-      edgeUePositionAlloc->Add (Vector (distance * 0.5, distance * 0.28867, 0.0));  // edgeUE1
-      edgeUePositionAlloc->Add (Vector (distance * 0.5, distance * 0.28867, 0.0));  // edgeUE2
-      edgeUePositionAlloc->Add (Vector (distance * 0.5, distance * 0.28867, 0.0));  // edgeUE3
+    for (uint32_t i = 0; i < nCells; i++) {
+      for (int j = 0; j < numEdgeUes; j++) {
+        if (config.hexRings == 0) {
+          edgeUePositionAlloc->Add (Vector (distance * 0.5, distance * 0.28867, 0.0));
+        } else {
+          edgeUePositionAlloc->Add (hex.GetEdgePosition (i, j));
+        }
+      }
     }
     mobility.SetPositionAllocator (edgeUePositionAlloc);
     mobility.Install (edgeUeNodes);
@@ -187,7 +350,7 @@ main (int argc, char *argv[])
     pauseConstantVariableStream << "ns3::ConstantRandomVariable[Constant="
                                   << pause
                                     << "]"; 
-    for (int i = 0; i < 3; ++i) {
+    for (uint32_t i = 0; i < nCells; ++i) {
       Box macroUeBox = bounds[i];
       ostringstream xUniformRandomVariableStream;
       xUniformRandomVariableStream << "ns3::UniformRandomVariable[Min="
@@ -221,48 +384,14 @@ main (int argc, char *argv[])
   // Install LTE Devices to the nodes
   // Install the IP stack on the UEs
   // Assign IP address to UEs
-  NetDeviceContainer enbLteDevs;
   if(algo == "NoOp")
   {
     lteHelper->SetFfrAlgorithmType ("ns3::LteFrNoOpAlgorithm");
-    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (1));
-    enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (0)));
-
-    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (2));
-    enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (1)));
-
-    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (3));
-    enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (2)));
-
-    //FR algorithm reconfiguration if needed
-    PointerValue tmp;
-    enbLteDevs.Get (0)->GetAttribute ("LteFfrAlgorithm", tmp);
-    Ptr<LteFfrAlgorithm> ffrAlgorithm = DynamicCast<LteFfrAlgorithm> (tmp.GetObject ());
-    ffrAlgorithm->SetAttribute ("FrCellTypeId", UintegerValue (1));
 
   } else if (algo == "Hard") {
     lteHelper->SetFfrAlgorithmType ("ns3::LteFrHardAlgorithm");
     lteHelper->SetFfrAlgorithmAttribute ("UlSubBandwidth", UintegerValue (8));
 
-    //for the fist cell**
-    lteHelper->SetFfrAlgorithmAttribute ("UlSubBandOffset", UintegerValue (0));
-    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (1));
-    enbLteDevs.Add(lteHelper->InstallEnbDevice (enbNodes.Get(0)));//for the second cell lteHelper->SetFfrAlgorithmAttribute ("DlSubBandOffset", UintegerValue (8));
-    
-    lteHelper->SetFfrAlgorithmAttribute ("UlSubBandOffset", UintegerValue (8));
-    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (2));
-    enbLteDevs.Add(lteHelper->InstallEnbDevice (enbNodes.Get(1)));//for the third cell** lteHelper->SetFfrAlgorithmAttribute ("DlSubBandOffset", UintegerValue (16));
-    
-    lteHelper->SetFfrAlgorithmAttribute ("UlSubBandOffset", UintegerValue (16));
-    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (3));
-    enbLteDevs.Add(lteHelper->InstallEnbDevice (enbNodes.Get(2)));
-
-      //FR algorithm reconfiguration if needed
-    PointerValue tmp;
-    enbLteDevs.Get (0)->GetAttribute ("LteFfrAlgorithm", tmp);
-    Ptr<LteFfrAlgorithm> ffrAlgorithm = DynamicCast<LteFfrAlgorithm> (tmp.GetObject ());
-    ffrAlgorithm->SetAttribute ("FrCellTypeId", UintegerValue (1));
-  
   } else {
      lteHelper->SetFfrAlgorithmType ("ns3::LteFrStrictAlgorithm");
             
@@ -280,28 +409,26 @@ main (int argc, char *argv[])
       lteHelper->SetFfrAlgorithmAttribute ("UlEdgeSubBandwidth", UintegerValue (4));
       lteHelper->SetFfrAlgorithmAttribute ("CenterAreaTpc", UintegerValue (1));
       lteHelper->SetFfrAlgorithmAttribute ("EdgeAreaTpc", UintegerValue (2));
+  }
 
-      lteHelper->SetFfrAlgorithmAttribute ("UlEdgeSubBandOffset", UintegerValue (12));
-      lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (1));
-      enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (0)));
-
-      //node 2
-      lteHelper->SetFfrAlgorithmAttribute ("UlEdgeSubBandOffset", UintegerValue (16));
-      lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (2));
-      enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (1)));
-
-      //node 3
-      lteHelper->SetFfrAlgorithmAttribute ("UlEdgeSubBandOffset", UintegerValue (20));
-      lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (3));
-      enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (2)));
-
-      //FR algorithm reconfiguration if needed
-      PointerValue tmp;
-      enbLteDevs.Get (0)->GetAttribute ("LteFfrAlgorithm", tmp);
-      Ptr<LteFfrAlgorithm> ffrAlgorithm = DynamicCast<LteFfrAlgorithm> (tmp.GetObject ());
-      ffrAlgorithm->SetAttribute ("FrCellTypeId", UintegerValue (1));
+  // the uplink sub-band of a cell follows from its FrCellTypeId
+  NetDeviceContainer enbLteDevs;
+  for (uint32_t i = 0; i < nCells; i++) {
+    if (algo == "Hard") {
+      lteHelper->SetFfrAlgorithmAttribute ("UlSubBandOffset", UintegerValue (8 * (cellTypes[i] - 1)));
+    } else if (algo != "NoOp") {
+      lteHelper->SetFfrAlgorithmAttribute ("UlEdgeSubBandOffset", UintegerValue (12 + 4 * (cellTypes[i] - 1)));
+    }
+    lteHelper->SetFfrAlgorithmAttribute ("FrCellTypeId", UintegerValue (cellTypes[i]));
+    enbLteDevs.Add (lteHelper->InstallEnbDevice (enbNodes.Get (i)));
   }
 
+  //FR algorithm reconfiguration if needed
+  PointerValue tmp;
+  enbLteDevs.Get (0)->GetAttribute ("LteFfrAlgorithm", tmp);
+  Ptr<LteFfrAlgorithm> ffrAlgorithm = DynamicCast<LteFfrAlgorithm> (tmp.GetObject ());
+  ffrAlgorithm->SetAttribute ("FrCellTypeId", UintegerValue (cellTypes[0]));
+
   NetDeviceContainer centerUeLteDevs, edgeUeLteDevs, randomUeLteDevs;
   if (centerUeNodes.GetN() > 0) {
     centerUeLteDevs = lteHelper->InstallUeDevice (centerUeNodes);
@@ -320,8 +447,29 @@ main (int argc, char *argv[])
 
   }
   
+  Ptr<LteInterferenceCulling> culling;
+  if (config.cullingMarginDb >= 0)
+    {
+      NetDeviceContainer ueLteDevs (centerUeLteDevs, edgeUeLteDevs);
+      ueLteDevs.Add (randomUeLteDevs);
+      culling = Create<LteInterferenceCulling> (config.cullingMarginDb);
+      culling->Install (lteHelper, enbLteDevs, ueLteDevs);
+    }
+
+  if (config.pathlossCache)
+    {
+      // eNBs, center and edge UEs never move: precompute their pathloss
+      NodeContainer ueNodes (centerUeNodes, edgeUeNodes);
+      ueNodes.Add (randomUeNodes);
+      Ptr<SpectrumChannel> channels[] = {lteHelper->GetDownlinkSpectrumChannel (), lteHelper->GetUplinkSpectrumChannel ()};
+      for (int c = 0; c < 2; ++c)
+        {
+          DynamicCast<CachedPropagationLossModel> (channels[c]->GetPropagationLossModel ())->Precompute (enbNodes, ueNodes);
+        }
+    }
+
   // Install center applications
-  for (uint32_t i = 0; i < numCenterUes * 3; i++) {
+  for (uint32_t i = 0; i < centerUeNodes.GetN (); i++) {
       Ptr<Node> centerUeNode = centerUeNodes.Get (i);
 
       // Set the default gateway for the UE
@@ -330,7 +478,7 @@ main (int argc, char *argv[])
   }
 
   // Install edge applications
-  for (uint32_t i = 0; i < numEdgeUes * 3; i++) {
+  for (uint32_t i = 0; i < edgeUeNodes.GetN (); i++) {
       Ptr<Node> edgeUeNode = edgeUeNodes.Get (i);
 
       // Set the default gateway for the UE
@@ -339,7 +487,7 @@ main (int argc, char *argv[])
   }
 
   // Install random applications
-  for (uint32_t i = 0; i < numRandomUes * 3; i++) {
+  for (uint32_t i = 0; i < randomUeNodes.GetN (); i++) {
     Ptr<Node> randomUeNode = randomUeNodes.Get (i);
 
     // Set the default gateway for the UE
@@ -348,7 +496,7 @@ main (int argc, char *argv[])
   }
 
   // Attach UEs to eNodeBs
-  for (uint16_t i = 0; i < 3; i++) {
+  for (uint32_t i = 0; i < nCells; i++) {
     for (uint16_t j = 0; j < numCenterUes; j++) {
       lteHelper->Attach (centerUeLteDevs.Get(i * numCenterUes + j), enbLteDevs.Get(i));
     }
@@ -361,48 +509,72 @@ main (int argc, char *argv[])
     // side effect: the default EPS bearer will be activated
   }
 
-  // Install and start applications on UEs and remote host
-  uint16_t ulPort = 2000;
+  // Install and start applications on UEs and remote host.  Every flow has
+  // its own sink, on a port above 2000; once the ports of the remote host
+  // address run out, the sinks move on to further addresses of the remote host
+  const uint32_t portsPerAddress = 65535 - 2000;
+  uint32_t nFlows = 0;
+  auto nextSinkAddress = [&] () -> InetSocketAddress
+  {
+    uint32_t a = nFlows / portsPerAddress;
+    uint16_t port = 2001 + nFlows % portsPerAddress;
+    Ipv4Address addr (remoteHostAddr.Get () + a);
+    if (a > 0 && port == 2001)
+      {
+        remoteHost->GetObject<Ipv4> ()->AddAddress (1, Ipv4InterfaceAddress (addr, Ipv4Mask ("255.0.0.0")));
+      }
+    ++nFlows;
+    return InetSocketAddress (addr, port);
+  };
+  // without a limit, enough packets to keep every client sending until simTime
+  uint32_t maxPackets = config.maxPackets;
+  if (maxPackets == 0)
+    {
+      maxPackets = static_cast<uint32_t> (ceil ((simTime - .5) / interPacketInterval.GetSeconds ())) + 1;
+    }
   ApplicationContainer clientApps;
   ApplicationContainer serverCenterApps;
   ApplicationContainer serverEdgeApps;
   ApplicationContainer serverRandomApps;
 
-  for (uint32_t i = 0; i < 3; ++i) {
+  for (uint32_t i = 0; i < nCells; ++i) {
     
     //add apps for center ues
     for (int j = 0; j < numCenterUes; ++j) {
-      ++ulPort;
-      PacketSinkHelper ulPacketSinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), ulPort));
+      InetSocketAddress sinkAddress = nextSinkAddress ();
+      PacketSinkHelper ulPacketSinkHelper ("ns3::UdpSocketFactory", sinkAddress);
       serverCenterApps.Add (ulPacketSinkHelper.Install (remoteHost));
 
-      UdpClientHelper ulClient (remoteHostAddr, ulPort);
+      UdpClientHelper ulClient (sinkAddress.GetIpv4 (), sinkAddress.GetPort ());
       ulClient.SetAttribute ("Interval", TimeValue (interPacketInterval));
-      ulClient.SetAttribute ("MaxPackets", UintegerValue (10000));
+      ulClient.SetAttribute ("MaxPackets", UintegerValue (maxPackets));
+      ulClient.SetAttribute ("PacketSize", UintegerValue (UL_PACKET_SIZE));
       clientApps.Add (ulClient.Install (centerUeNodes.Get(i * numCenterUes + j)));
     }
 
     //add apps for edge ues
     for (int j = 0; j < numEdgeUes; ++j) {
-      ++ulPort;
-      PacketSinkHelper ulPacketSinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), ulPort));
+      InetSocketAddress sinkAddress = nextSinkAddress ();
+      PacketSinkHelper ulPacketSinkHelper ("ns3::UdpSocketFactory", sinkAddress);
       serverEdgeApps.Add (ulPacketSinkHelper.Install (remoteHost));
 
-      UdpClientHelper ulClient (remoteHostAddr, ulPort);
+      UdpClientHelper ulClient (sinkAddress.GetIpv4 (), sinkAddress.GetPort ());
       ulClient.SetAttribute ("Interval", TimeValue (interPacketInterval));
-      ulClient.SetAttribute ("MaxPackets", UintegerValue (10000));
+      ulClient.SetAttribute ("MaxPackets", UintegerValue (maxPackets));
+      ulClient.SetAttribute ("PacketSize", UintegerValue (UL_PACKET_SIZE));
       clientApps.Add (ulClient.Install (edgeUeNodes.Get(i * numEdgeUes + j)));
     }
 
     //add apps for random ues
     for (int j = 0; j < numRandomUes; ++j) {
-      ++ulPort;
-      PacketSinkHelper ulPacketSinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), ulPort));
+      InetSocketAddress sinkAddress = nextSinkAddress ();
+      PacketSinkHelper ulPacketSinkHelper ("ns3::UdpSocketFactory", sinkAddress);
       serverRandomApps.Add (ulPacketSinkHelper.Install (remoteHost));
 
-      UdpClientHelper ulClient (remoteHostAddr, ulPort);
+      UdpClientHelper ulClient (sinkAddress.GetIpv4 (), sinkAddress.GetPort ());
       ulClient.SetAttribute ("Interval", TimeValue (interPacketInterval));
-      ulClient.SetAttribute ("MaxPackets", UintegerValue (10000));
+      ulClient.SetAttribute ("MaxPackets", UintegerValue (maxPackets));
+      ulClient.SetAttribute ("PacketSize", UintegerValue (UL_PACKET_SIZE));
       clientApps.Add (ulClient.Install (randomUeNodes.Get(i * numRandomUes + j)));
     }
   }
@@ -415,63 +587,1236 @@ main (int argc, char *argv[])
     serverRandomApps.Start (MilliSeconds (500));
 
   clientApps.Start (MilliSeconds (500));
-  lteHelper->EnableTraces ();
+
+  Ptr<GoodputMonitor> goodputMonitor;
+  if (config.goodputWindow.IsStrictlyPositive ())
+    {
+      goodputMonitor = Create<GoodputMonitor> (config.goodputOutput, config.goodputWindow, MilliSeconds (500));
+      for (uint32_t i = 0; i < nCells; i++)
+        {
+          for (uint16_t j = 0; j < numCenterUes; ++j)
+            {
+              goodputMonitor->AddFlow (serverCenterApps.Get (i * numCenterUes + j), i, "Center", j);
+            }
+          for (uint16_t j = 0; j < numEdgeUes; ++j)
+            {
+              goodputMonitor->AddFlow (serverEdgeApps.Get (i * numEdgeUes + j), i, "Edge", j);
+            }
+          for (uint16_t j = 0; j < numRandomUes; ++j)
+            {
+              goodputMonitor->AddFlow (serverRandomApps.Get (i * numRandomUes + j), i, "Random", j);
+            }
+        }
+      goodputMonitor->Start (Seconds (simTime));
+    }
+
+  Ptr<GoodputConvergenceMonitor> convergence;
+  if (config.stopHalfWidth > 0)
+    {
+      convergence = Create<GoodputConvergenceMonitor> (config.stopBatch, MilliSeconds (500), config.stopHalfWidth,
+                                                       config.confidence, config.stopMinBatches);
+      for (uint32_t a = 0; a < serverCenterApps.GetN (); ++a)
+        {
+          convergence->AddFlow (serverCenterApps.Get (a), "Center");
+        }
+      for (uint32_t a = 0; a < serverEdgeApps.GetN (); ++a)
+        {
+          convergence->AddFlow (serverEdgeApps.Get (a), "Edge");
+        }
+      for (uint32_t a = 0; a < serverRandomApps.GetN (); ++a)
+        {
+          convergence->AddFlow (serverRandomApps.Get (a), "Random");
+        }
+      convergence->Start (Seconds (simTime));
+    }
+  Ptr<SteadyStateGoodput> steadyState;
+  if (config.warmupDetection)
+    {
+      // flows in the order of collectGoodputs
+      steadyState = Create<SteadyStateGoodput> (config.warmupWindow, MilliSeconds (500));
+      for (uint32_t i = 0; i < nCells; i++)
+        {
+          for (uint16_t j = 0; j < numCenterUes; ++j)
+            {
+              steadyState->AddFlow (serverCenterApps.Get (i * numCenterUes + j));
+            }
+          for (uint16_t j = 0; j < numEdgeUes; ++j)
+            {
+              steadyState->AddFlow (serverEdgeApps.Get (i * numEdgeUes + j));
+            }
+          for (uint16_t j = 0; j < numRandomUes; ++j)
+            {
+              steadyState->AddFlow (serverRandomApps.Get (i * numRandomUes + j));
+            }
+        }
+      steadyState->Start (Seconds (simTime));
+      if (convergence)
+        {
+          convergence->SetWarmupDetection (true);
+        }
+    }
+
+  // measurement time of the goodputs, shorter than simTime - 0.5 s after an early stop
+  double measuredTime = simTime - .5;
+
+  Ptr<LteBinaryTraceHelper> binaryTraces;
+  if (config.enableTraces && config.binaryTraces)
+    {
+      NetDeviceContainer ueLteDevs (centerUeLteDevs, edgeUeLteDevs);
+      ueLteDevs.Add (randomUeLteDevs);
+      binaryTraces = Create<LteBinaryTraceHelper> ("", config.compressTraces);
+      binaryTraces->Install (enbLteDevs, ueLteDevs);
+    }
+  else if (config.enableTraces)
+    {
+      lteHelper->EnableTraces ();
+    }
   // Uncomment to enable PCAP tracing
   //p2ph.EnablePcapAll("lena-simple-epc");
 
-  Simulator::Stop (Seconds(simTime));
+  // delay of every flow, in the order of collectGoodputs
+  vector<DelayStats> delays (serverCenterApps.GetN () + serverEdgeApps.GetN () + serverRandomApps.GetN ());
+  size_t k = 0;
+  for (uint32_t i = 0; i < nCells; i++)
+    {
+      for (uint16_t j = 0; j < numCenterUes; ++j, ++k)
+        {
+          serverCenterApps.Get (i * numCenterUes + j)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&RecordDelay, &delays[k]));
+        }
+      for (uint16_t j = 0; j < numEdgeUes; ++j, ++k)
+        {
+          serverEdgeApps.Get (i * numEdgeUes + j)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&RecordDelay, &delays[k]));
+        }
+      for (uint16_t j = 0; j < numRandomUes; ++j, ++k)
+        {
+          serverRandomApps.Get (i * numRandomUes + j)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&RecordDelay, &delays[k]));
+        }
+    }
+
+  // goodput of every flow, ordered by eNB, then class, then flow
+  auto collectGoodputs = [&] () -> vector<FlowGoodput>
+  {
+    vector<FlowGoodput> results;
+    for (uint32_t i = 0; i < nCells; i++) {
+      for (uint16_t j = 0; j < numCenterUes; ++j) {
+        double center = DynamicCast<PacketSink> (serverCenterApps.Get(i * numCenterUes + j))->GetTotalRx ();
+        FlowGoodput g = {i, "Center", j, center * 8 / measuredTime};
+        results.push_back (g);
+      }
+      for (uint16_t j = 0; j < numEdgeUes; ++j) {
+        double edge = DynamicCast<PacketSink> (serverEdgeApps.Get(i * numEdgeUes + j))->GetTotalRx ();
+        FlowGoodput g = {i, "Edge", j, edge * 8 / measuredTime};
+        results.push_back (g);
+      }
+      for (uint16_t j = 0; j < numRandomUes; ++j) {
+        double random = DynamicCast<PacketSink> (serverRandomApps.Get(i * numRandomUes + j))->GetTotalRx ();
+        FlowGoodput g = {i, "Random", j, random * 8 / measuredTime};
+        results.push_back (g);
+      }
+    }
+    for (size_t k = 0; k < results.size (); ++k)
+      {
+        results[k].warmupEnd = steadyState ? steadyState->GetWarmupEnd (k).GetSeconds () : 0.5;
+        results[k].delay = delays[k].packets > 0 ? delays[k].sum / delays[k].packets : 0.0;
+        if (steadyState)
+          {
+            results[k].goodput = steadyState->GetGoodput (k);
+          }
+      }
+    return results;
+  };
+
+  if (variants.empty ())
+    {
+      Simulator::Stop (Seconds(simTime));
+      Simulator::Run ();
+      measuredTime = Simulator::Now ().GetSeconds () - .5;
+      if (convergence)
+        {
+          convergence->Report (cerr);
+        }
+
+      /*GtkConfigStore config;
+      config.ConfigureAttributes();*/
+
+      Simulator::Destroy ();
+      if (binaryTraces)
+        {
+          binaryTraces->Close ();
+        }
+      if (culling)
+        {
+          culling->Report (cerr);
+        }
+      return vector<vector<FlowGoodput> > (1, collectGoodputs ());
+    }
+
+  // Warm up: run until just before the applications start, so that no
+  // packet has been sent yet when the children change the traffic
+  Simulator::Stop (MilliSeconds (500) - TimeStep (1));
   Simulator::Run ();
 
-  /*GtkConfigStore config;
-  config.ConfigureAttributes();*/
+  NodeContainer ueNodes (centerUeNodes, edgeUeNodes);
+  ueNodes.Add (randomUeNodes);
+  NetDeviceContainer ueLteDevs (centerUeLteDevs, edgeUeLteDevs);
+  ueLteDevs.Add (randomUeLteDevs);
+  SimProcessPool pool (jobs);
+  for (size_t v = 0; v < variants.size (); ++v)
+    {
+      WarmStartVariant variant = variants[v];
+      pool.Submit ([&, variant] (ostream &out)
+        {
+          // streams created from now on use the new run; re-create those
+          // that still draw numbers after the warm-up
+          RngSeedManager::SetRun (variant.run);
+          int64_t stream = 1;
+          stream += lteHelper->AssignStreams (enbLteDevs, stream);
+          stream += lteHelper->AssignStreams (ueLteDevs, stream);
+          stream += mobility.AssignStreams (ueNodes, stream);
+          for (uint32_t a = 0; a < clientApps.GetN (); ++a)
+            {
+              clientApps.Get (a)->SetAttribute ("Interval", TimeValue (variant.interPacketInterval));
+            }
 
+          Simulator::Stop (Seconds (simTime) - Simulator::Now ());
+          Simulator::Run ();
+          measuredTime = Simulator::Now ().GetSeconds () - .5;
+          Simulator::Destroy ();
+          WriteGoodputs (out, collectGoodputs ());
+        });
+    }
+  cerr << "Forking " << variants.size () << " warm-started runs on "
+       << pool.GetMaxWorkers () << " workers" << endl;
+  vector<SimProcessPool::JobResult> runs = pool.Run ();
   Simulator::Destroy ();
 
-  // calculate goodputs
+  vector<vector<FlowGoodput> > results;
+  for (size_t v = 0; v < runs.size (); ++v)
+    {
+      if (!runs[v].Ok ())
+        {
+          cerr << "Warm-started run " << v << " (run " << variants[v].run
+               << ") failed with status " << runs[v].status << endl;
+        }
+      results.push_back (ReadGoodputs (runs[v].output));
+    }
+  return results;
+}
+
+/**
+ * Build and run the scenario described by config.
+ * \return the goodput of every flow, ordered by eNB, then class, then flow
+ */
+static vector<FlowGoodput>
+RunScenario (const ScenarioConfig &config)
+{
+  return RunScenario (config, vector<WarmStartVariant> (), 0)[0];
+}
+
+/**
+ * Print the per-flow, per-class and per-eNB goodput report of a single
+ * run, with the detected end of the warm-up of every flow if showWarmup
+ */
+static void
+PrintGoodputReport (const vector<FlowGoodput> &results, uint32_t nCells, bool showWarmup = false)
+{
   double total_sum = 0;
+  size_t k = 0;
 
-  for (int i = 0; i < 3; i++) {
+  for (uint32_t i = 0; i < nCells; i++) {
     double pair_sum = 0;
-    double center_sum = 0;
-    double edge_sum = 0;
-    double random_sum = 0;
 
     cout << "EnB " << i << "\n\n";
 
-    // center ue goodputs
-    for (int j = 0; j < numCenterUes; ++j) {
-      double center = DynamicCast<PacketSink> (serverCenterApps.Get(i * numCenterUes + j))->GetTotalRx ();
-      double center_goodput = center * 8 / (simTime - .5);
-      cout << "Center Flow " << j << " Goodput: " << center_goodput/1000000 << " Mbps\n";
-      center_sum += center_goodput;
+    const char *classes[] = {"Center", "Edge", "Random"};
+    for (int c = 0; c < 3; ++c) {
+      double class_sum = 0;
+      for (; k < results.size () && results[k].enb == i && results[k].ueClass == classes[c]; ++k) {
+        cout << classes[c] << " Flow " << results[k].flow << " Goodput: " << results[k].goodput/1000000 << " Mbps";
+        if (showWarmup) {
+          cout << " (steady state from " << results[k].warmupEnd << " s)";
+        }
+        cout << "\n";
+        class_sum += results[k].goodput;
+      }
+      cout << "Sum " << classes[c] << " Goodput: " << class_sum/1000000 << " Mbps\n\n";
+      pair_sum += class_sum;
     }
-    cout << "Sum Center Goodput: " << center_sum/1000000 << " Mbps\n\n";
-    pair_sum += center_sum;
 
-    // edge ue goodputs
-    for (int j = 0; j < numEdgeUes; ++j) {
-      double edge = DynamicCast<PacketSink> (serverEdgeApps.Get(i * numEdgeUes + j))->GetTotalRx ();
-      double edge_goodput = edge * 8 / (simTime - .5);
-      cout << "Edge Flow " << j << " Goodput: " << edge_goodput/1000000 << " Mbps\n";
-      edge_sum += edge_goodput;
+    cout << "EnB " << i << " Goodput: " << pair_sum/1000000 << " Mbps\n\n";
+    total_sum += pair_sum;
+  }
+  cout << "Total Goodput " << total_sum/1000000 << " Mbps\n";
+}
+
+/// Split a comma separated command line list, dropping empty items
+static vector<string>
+SplitList (const string &list)
+{
+  vector<string> items;
+  istringstream is (list);
+  string item;
+  while (getline (is, item, ','))
+    {
+      if (!item.empty ())
+        {
+          items.push_back (item);
+        }
     }
-    cout << "Sum Edge Goodput: " << edge_sum/1000000 << " Mbps\n\n";
-    pair_sum += edge_sum;
+  return items;
+}
 
-    // random ue goodputs
-    for (int j = 0; j < numRandomUes; ++j) {
-      double random = DynamicCast<PacketSink> (serverRandomApps.Get(i * numRandomUes + j))->GetTotalRx ();
-      double random_goodput = random * 8 / (simTime - .5);
-      cout << "Random Flow " << j << " Goodput: " << random_goodput/1000000 << " Mbps\n";
-      random_sum += random_goodput;
+static vector<uint32_t>
+SplitUintList (const string &list)
+{
+  vector<uint32_t> values;
+  vector<string> items = SplitList (list);
+  for (size_t i = 0; i < items.size (); ++i)
+    {
+      values.push_back (static_cast<uint32_t> (stoul (items[i])));
     }
-    cout << "Sum Random Goodput: " << random_sum/1000000 << " Mbps\n\n";
-    pair_sum += random_sum;
+  return values;
+}
 
-    cout << "EnB " << i << " Goodput: " << pair_sum/1000000 << " Mbps\n\n";
-    total_sum += pair_sum;
+/**
+ * Canonical one-line description of a run of config with RNG run run,
+ * the scenario part of its ResultStore key; every field of ScenarioConfig
+ * that can change the goodputs must be in it.
+ */
+static string
+DescribeScenario (const ScenarioConfig &config, uint32_t run)
+{
+  ostringstream os;
+  os.precision (17);
+  os << "Final-Project-Script simTime=" << config.simTime << " distance=" << config.distance
+     << " interPacketInterval=" << config.interPacketInterval.GetTimeStep ()
+     << " numCenterUes=" << config.numCenterUes << " numEdgeUes=" << config.numEdgeUes
+     << " numRandomUes=" << config.numRandomUes << " algo=" << config.algo
+     << " seed=" << config.seed << " run=" << run
+     << " hexRings=" << config.hexRings << " wrapAround=" << config.wrapAround
+     << " pathlossCache=" << config.pathlossCache << " cullingMarginDb=" << config.cullingMarginDb
+     << " scheduler=" << config.scheduler
+     << " stopHalfWidth=" << config.stopHalfWidth << " stopBatch=" << config.stopBatch.GetTimeStep ()
+     << " stopMinBatches=" << config.stopMinBatches << " confidence=" << config.confidence
+     << " warmupDetection=" << config.warmupDetection << " warmupWindow=" << config.warmupWindow.GetTimeStep ()
+     << " maxPackets=" << config.maxPackets;
+  return os.str ();
+}
+
+/**
+ * \return true if everything a run of config produces is its goodputs,
+ * so that a stored result can stand in for the run
+ */
+static bool
+IsStorable (const ScenarioConfig &config)
+{
+  return !config.enableTraces && !config.goodputWindow.IsStrictlyPositive () && !config.schedulerCost;
+}
+
+/**
+ * Run configs[i] with RNG run runs[i] on a bounded pool of worker
+ * processes, each writing its goodputs, except the runs whose result is
+ * already in store; the results of the new runs are added to the store.
+ * \return one result per config, in order, with the stored ones as if they had run
+ */
+static vector<SimProcessPool::JobResult>
+RunStoredScenarios (const vector<ScenarioConfig> &configs, const vector<uint32_t> &runs,
+                    const ResultStore &store, unsigned jobs, const string &what)
+{
+  vector<SimProcessPool::JobResult> results (configs.size ());
+  vector<string> scenarios (configs.size ());
+  vector<size_t> submitted;
+  SimProcessPool pool (jobs);
+  for (size_t i = 0; i < configs.size (); ++i)
+    {
+      ScenarioConfig config = configs[i];
+      uint32_t run = runs[i];
+      scenarios[i] = DescribeScenario (config, run);
+      if (IsStorable (config) && store.Lookup (scenarios[i], results[i].output))
+        {
+          results[i].status = 0;
+          continue;
+        }
+      submitted.push_back (i);
+      pool.Submit ([config, run] (ostream &out)
+        {
+          RngSeedManager::SetRun (run);
+          WriteGoodputs (out, RunScenario (config));
+        });
+    }
+  cerr << "Running " << submitted.size () << " " << what << " on " << pool.GetMaxWorkers () << " workers";
+  if (configs.size () > submitted.size ())
+    {
+      cerr << ", " << configs.size () - submitted.size () << " more from the result store";
+    }
+  cerr << endl;
+  vector<SimProcessPool::JobResult> newResults = pool.Run ();
+  for (size_t k = 0; k < submitted.size (); ++k)
+    {
+      size_t i = submitted[k];
+      results[i] = newResults[k];
+      if (results[i].Ok () && IsStorable (configs[i]))
+        {
+          store.Store (scenarios[i], results[i].output);
+        }
+    }
+  return results;
+}
+
+/**
+ * Write one CSV row per flow and one per eNB sum, each starting with
+ * prefix: prefix,enb,class,flow,goodputMbps
+ */
+static void
+WriteGoodputTable (ostream &os, const string &prefix, const vector<FlowGoodput> &results, uint32_t nCells)
+{
+  vector<double> enbSum (nCells, 0.0);
+  for (size_t k = 0; k < results.size (); ++k)
+    {
+      const FlowGoodput &g = results[k];
+      os << prefix << "," << g.enb << "," << g.ueClass << "," << g.flow
+         << "," << g.goodput / 1000000 << "\n";
+      enbSum[g.enb] += g.goodput;
+    }
+  for (uint32_t e = 0; e < enbSum.size (); ++e)
+    {
+      os << prefix << "," << e << ",EnB,sum," << enbSum[e] / 1000000 << "\n";
+    }
+}
+
+/**
+ * Run the Cartesian product of the given parameter lists, each
+ * combination once per seed, on a bounded pool of worker processes;
+ * combinations whose result is in store are not run again.
+ * Every per-flow goodput and every per-eNB sum is written to one merged
+ * CSV table on os.
+ */
+static void
+RunSweep (const ScenarioConfig &base,
+          const vector<string> &algos,
+          const vector<uint32_t> &centerUes,
+          const vector<uint32_t> &edgeUes,
+          const vector<uint32_t> &randomUes,
+          const vector<uint32_t> &seeds,
+          const ResultStore &store,
+          unsigned jobs,
+          ostream &os)
+{
+  vector<ScenarioConfig> configs;
+  for (size_t a = 0; a < algos.size (); ++a)
+    for (size_t c = 0; c < centerUes.size (); ++c)
+      for (size_t e = 0; e < edgeUes.size (); ++e)
+        for (size_t r = 0; r < randomUes.size (); ++r)
+          for (size_t s = 0; s < seeds.size (); ++s)
+            {
+              ScenarioConfig config = base;
+              config.algo = algos[a];
+              config.numCenterUes = centerUes[c];
+              config.numEdgeUes = edgeUes[e];
+              config.numRandomUes = randomUes[r];
+              config.seed = seeds[s];
+              configs.push_back (config);
+            }
+
+  for (size_t i = 0; i < configs.size (); ++i)
+    {
+      ScenarioConfig &config = configs[i];
+      if (config.goodputWindow.IsStrictlyPositive ())
+        {
+          // one series per run: <stem>-run<i><extension>
+          string::size_type dot = config.goodputOutput.rfind ('.');
+          if (dot == string::npos)
+            {
+              dot = config.goodputOutput.size ();
+            }
+          ostringstream name;
+          name << config.goodputOutput.substr (0, dot) << "-run" << i << config.goodputOutput.substr (dot);
+          config.goodputOutput = name.str ();
+        }
+    }
+  vector<SimProcessPool::JobResult> runs =
+    RunStoredScenarios (configs, vector<uint32_t> (configs.size (), RngSeedManager::GetRun ()), store, jobs, "scenarios");
+
+  os << "run,algo,numCenterUes,numEdgeUes,numRandomUes,seed,enb,class,flow,goodputMbps\n";
+  for (size_t i = 0; i < runs.size (); ++i)
+    {
+      const ScenarioConfig &config = configs[i];
+      if (!runs[i].Ok ())
+        {
+          cerr << "Run " << i << " (" << config.algo << ", seed " << config.seed
+               << ") failed with status " << runs[i].status << endl;
+          continue;
+        }
+      ostringstream prefix;
+      prefix << i << "," << config.algo << "," << config.numCenterUes << ","
+             << config.numEdgeUes << "," << config.numRandomUes << "," << config.seed;
+
+      WriteGoodputTable (os, prefix.str (), ReadGoodputs (runs[i].output), GetNumberOfCells (config));
+    }
+}
+
+/// The FF MAC schedulers of the LTE module
+static const char *const ALL_SCHEDULERS[] = {
+  "ns3::PfFfMacScheduler", "ns3::RrFfMacScheduler", "ns3::TdMtFfMacScheduler", "ns3::FdMtFfMacScheduler",
+  "ns3::TtaFfMacScheduler", "ns3::TdBetFfMacScheduler", "ns3::FdBetFfMacScheduler", "ns3::TdTbfqFfMacScheduler",
+  "ns3::FdTbfqFfMacScheduler", "ns3::PssFfMacScheduler", "ns3::CqaFfMacScheduler"
+};
+
+/// Expand a short scheduler name, e.g. "Pf", to its type, ns3::PfFfMacScheduler
+static string
+GetSchedulerType (const string &name)
+{
+  if (name.find ("::") != string::npos)
+    {
+      return name;
+    }
+  const string suffix = "FfMacScheduler";
+  bool hasSuffix = name.size () >= suffix.size ()
+    && name.compare (name.size () - suffix.size (), suffix.size (), suffix) == 0;
+  return "ns3::" + name + (hasSuffix ? "" : suffix);
+}
+
+/// Jain's fairness index of the goodputs of results, 1 when all are equal
+static double
+GetJainIndex (const vector<FlowGoodput> &results)
+{
+  double sum = 0;
+  double sumSquares = 0;
+  for (size_t k = 0; k < results.size (); ++k)
+    {
+      sum += results[k].goodput;
+      sumSquares += results[k].goodput * results[k].goodput;
+    }
+  return sumSquares > 0 ? sum * sum / (results.size () * sumSquares) : 0.0;
+}
+
+/// p-th percentile (0 to 100) of the goodputs of results, interpolated
+static double
+GetGoodputPercentile (const vector<FlowGoodput> &results, double p)
+{
+  if (results.empty ())
+    {
+      return 0.0;
+    }
+  vector<double> values;
+  for (size_t k = 0; k < results.size (); ++k)
+    {
+      values.push_back (results[k].goodput);
+    }
+  sort (values.begin (), values.end ());
+  double x = p / 100 * (values.size () - 1);
+  size_t i = static_cast<size_t> (floor (x));
+  size_t j = min (i + 1, values.size () - 1);
+  return values[i] + (x - i) * (values[j] - values[i]);
+}
+
+/// Mean goodput of the flows of ueClass in results, 0 without flows
+static double
+GetClassMean (const vector<FlowGoodput> &results, const string &ueClass)
+{
+  double sum = 0;
+  uint32_t n = 0;
+  for (size_t k = 0; k < results.size (); ++k)
+    {
+      if (results[k].ueClass == ueClass)
+        {
+          sum += results[k].goodput;
+          ++n;
+        }
+    }
+  return n > 0 ? sum / n : 0.0;
+}
+
+/**
+ * Run the scenario once per scheduler and seed, on a bounded pool of
+ * worker processes, with every scheduler measured by TimedFfMacScheduler.
+ * One CSV row per run is written to os with the mean goodput per flow of
+ * each UE class, the total goodput, Jain's fairness index and the 5th
+ * percentile over all flows, the scheduler wall time per cell and TTI and
+ * the allocations per cell and TTI; the means over the seeds are printed.
+ */
+static void
+RunSchedulerShootout (const ScenarioConfig &base,
+                      const vector<string> &schedulers,
+                      const vector<uint32_t> &seeds,
+                      unsigned jobs,
+                      ostream &os)
+{
+  vector<ScenarioConfig> configs;
+  for (size_t k = 0; k < schedulers.size (); ++k)
+    for (size_t s = 0; s < seeds.size (); ++s)
+      {
+        ScenarioConfig config = base;
+        config.scheduler = schedulers[k];
+        config.seed = seeds[s];
+        config.schedulerCost = true;
+        configs.push_back (config);
+      }
+
+  SimProcessPool pool (jobs);
+  for (size_t i = 0; i < configs.size (); ++i)
+    {
+      ScenarioConfig config = configs[i];
+      pool.Submit ([config] (ostream &out)
+        {
+          WriteGoodputs (out, RunScenario (config));
+          const SchedulerCost &cost = TimedFfMacScheduler::GetTotalCost ();
+          out << "cost " << cost.dlTriggers << " " << cost.dlAllocations << " "
+              << cost.ulAllocations << " " << cost.seconds << "\n";
+        });
+    }
+  cerr << "Running " << configs.size () << " scheduler runs on "
+       << pool.GetMaxWorkers () << " workers" << endl;
+  vector<SimProcessPool::JobResult> runs = pool.Run ();
+
+  os << "run,scheduler,seed,centerMbps,edgeMbps,randomMbps,totalMbps,jainIndex,p5Mbps,"
+     << "cellTtis,schedulerUsPerTti,dlAllocationsPerTti,ulAllocationsPerTti\n";
+  // per scheduler: number of runs and sums of the printed columns
+  vector<uint32_t> okRuns (schedulers.size (), 0);
+  vector<vector<double> > sums (schedulers.size (), vector<double> (6, 0.0));
+  for (size_t i = 0; i < runs.size (); ++i)
+    {
+      const ScenarioConfig &config = configs[i];
+      string::size_type costPos = runs[i].output.find ("cost ");
+      if (!runs[i].Ok () || costPos == string::npos)
+        {
+          cerr << "Run " << i << " (" << config.scheduler << ", seed " << config.seed
+               << ") failed with status " << runs[i].status << endl;
+          continue;
+        }
+      vector<FlowGoodput> results = ReadGoodputs (runs[i].output);
+      SchedulerCost cost;
+      istringstream is (runs[i].output.substr (costPos + 5));
+      is >> cost.dlTriggers >> cost.dlAllocations >> cost.ulAllocations >> cost.seconds;
+
+      double total = 0;
+      for (size_t k = 0; k < results.size (); ++k)
+        {
+          total += results[k].goodput;
+        }
+      double ttis = max<double> (cost.dlTriggers, 1);
+      double row[] = {total / 1000000, GetJainIndex (results), GetGoodputPercentile (results, 5) / 1000000,
+                      cost.seconds * 1e6 / ttis, cost.dlAllocations / ttis, cost.ulAllocations / ttis};
+      os << i << "," << config.scheduler << "," << config.seed
+         << "," << GetClassMean (results, "Center") / 1000000
+         << "," << GetClassMean (results, "Edge") / 1000000
+         << "," << GetClassMean (results, "Random") / 1000000
+         << "," << row[0] << "," << row[1] << "," << row[2] << "," << cost.dlTriggers
+         << "," << row[3] << "," << row[4] << "," << row[5] << "\n";
+
+      size_t k = i / seeds.size ();
+      ++okRuns[k];
+      for (int c = 0; c < 6; ++c)
+        {
+          sums[k][c] += row[c];
+        }
+    }
+
+  cout << "scheduler\ttotalMbps\tjain\tp5Mbps\tusPerTti\tdlAllocsPerTti\tulAllocsPerTti\n";
+  for (size_t k = 0; k < schedulers.size (); ++k)
+    {
+      cout << schedulers[k];
+      for (int c = 0; c < 6; ++c)
+        {
+          cout << "\t" << (okRuns[k] > 0 ? sums[k][c] / okRuns[k] : 0.0);
+        }
+      cout << "\n";
+    }
+}
+
+/// Goodput statistics over replications, per flow, UE class, eNB and in total
+struct GoodputReplications
+{
+  /// Add the goodputs of one replication
+  void Add (const vector<FlowGoodput> &results, uint32_t nCells)
+  {
+    map<string, double> classSum;
+    vector<double> enbSum (nCells, 0.0);
+    double total = 0;
+    for (size_t k = 0; k < results.size (); ++k)
+      {
+        const FlowGoodput &g = results[k];
+        ostringstream key;
+        key << "flow," << g.enb << "," << g.ueClass << "," << g.flow;
+        AddValue (key.str (), g.goodput / 1000000);
+        classSum[g.ueClass] += g.goodput;
+        enbSum[g.enb] += g.goodput;
+        total += g.goodput;
+      }
+    for (map<string, double>::const_iterator it = classSum.begin (); it != classSum.end (); ++it)
+      {
+        AddValue ("class,," + it->first + ",", it->second / 1000000);
+      }
+    for (uint32_t e = 0; e < enbSum.size (); ++e)
+      {
+        ostringstream key;
+        key << "enb," << e << ",,";
+        AddValue (key.str (), enbSum[e] / 1000000);
+      }
+    AddValue ("total,,,", total / 1000000);
   }
-  cout << "Total Goodput " << total_sum/1000000 << " Mbps\n";
+
+  void AddValue (const string &key, double value)
+  {
+    if (stats.find (key) == stats.end ())
+      {
+        keys.push_back (key);
+      }
+    stats[key].Add (value);
+  }
+
+  /**
+   * Write one CSV row per quantity:
+   * level,enb,class,flow,n,meanMbps,stdDevMbps,ciLowMbps,ciHighMbps
+   */
+  void Write (ostream &os, double confidence) const
+  {
+    os << "level,enb,class,flow,n,meanMbps,stdDevMbps,ciLowMbps,ciHighMbps\n";
+    for (size_t i = 0; i < keys.size (); ++i)
+      {
+        const SampleStats &s = stats.find (keys[i])->second;
+        double h = s.GetCiHalfWidth (confidence);
+        os << keys[i] << "," << s.GetN () << "," << s.GetMean () << "," << s.GetStdDev ()
+           << "," << s.GetMean () - h << "," << s.GetMean () + h << "\n";
+      }
+  }
+
+  vector<string> keys;            ///< "level,enb,class,flow", in the order first added
+  map<string, SampleStats> stats; ///< [Mbps]
+};
+
+/**
+ * Run replications of the scenario as independent runs of the random
+ * number generator, firstRun, firstRun + 1, ..., all with the seed of
+ * base, on a bounded pool of worker processes.  The goodput of every
+ * flow, UE class, eNB and of the whole network is summarised over the
+ * replications with its mean, standard deviation and Student-t
+ * confidence interval at level confidence; the table is written to os
+ * and the class, eNB and total rows are printed.  Replications whose
+ * result is in store are not run again.
+ */
+static void
+RunReplications (const ScenarioConfig &base,
+                 uint32_t replications,
+                 uint32_t firstRun,
+                 double confidence,
+                 const ResultStore &store,
+                 unsigned jobs,
+                 ostream &os)
+{
+  vector<uint32_t> replicationRuns;
+  for (uint32_t r = 0; r < replications; ++r)
+    {
+      replicationRuns.push_back (firstRun + r);
+    }
+  vector<SimProcessPool::JobResult> runs =
+    RunStoredScenarios (vector<ScenarioConfig> (replications, base), replicationRuns, store, jobs, "replications");
+
+  GoodputReplications summary;
+  for (size_t r = 0; r < runs.size (); ++r)
+    {
+      if (!runs[r].Ok ())
+        {
+          cerr << "Replication " << r << " (run " << firstRun + r
+               << ") failed with status " << runs[r].status << endl;
+          continue;
+        }
+      summary.Add (ReadGoodputs (runs[r].output), GetNumberOfCells (base));
+    }
+  summary.Write (os, confidence);
+
+  cout << "level\tenb\tclass\tn\tmeanMbps\tstdDevMbps\tci" << confidence * 100 << "Mbps\n";
+  for (size_t i = 0; i < summary.keys.size (); ++i)
+    {
+      const string &key = summary.keys[i];
+      if (key.compare (0, 5, "flow,") == 0)
+        {
+          continue;
+        }
+      vector<string> fields;
+      istringstream is (key);
+      string field;
+      while (getline (is, field, ','))
+        {
+          fields.push_back (field);
+        }
+      fields.resize (3);
+      const SampleStats &s = summary.stats[key];
+      cout << fields[0] << "\t" << fields[1] << "\t" << fields[2] << "\t" << s.GetN ()
+           << "\t" << s.GetMean () << "\t" << s.GetStdDev ()
+           << "\t+-" << s.GetCiHalfWidth (confidence) << "\n";
+    }
+}
+
+/// Mean delay of the flows of ueClass that received packets, infinite without any [s]
+static double
+GetClassDelay (const vector<FlowGoodput> &results, const string &ueClass)
+{
+  double sum = 0;
+  uint32_t n = 0;
+  for (size_t k = 0; k < results.size (); ++k)
+    {
+      if (results[k].ueClass == ueClass && results[k].delay > 0)
+        {
+          sum += results[k].delay;
+          ++n;
+        }
+    }
+  return n > 0 ? sum / n : numeric_limits<double>::infinity ();
+}
+
+/**
+ * Find, for every FFR algorithm and UE class, the highest offered load
+ * per UE the class keeps up with: its mean goodput per flow is at least
+ * fraction of the offered load and its mean delay at most maxDelay.
+ *
+ * Every UE offers the same load.  The first round ramps it geometrically
+ * from minMbps to maxMbps in points steps; every following round puts
+ * points more loads inside the bracket between the highest load a class
+ * keeps up with and the next one, for every algorithm and class, so the
+ * brackets shrink by a factor of points + 1 per round.  All the runs of a
+ * round execute in parallel on a bounded pool of worker processes, and
+ * those already in store are not run again.  One CSV row per run and
+ * class is written to os and the capacities are printed.
+ */
+static void
+RunCapacitySearch (const ScenarioConfig &base,
+                   const vector<string> &algos,
+                   double fraction,
+                   Time maxDelay,
+                   double minMbps,
+                   double maxMbps,
+                   uint32_t points,
+                   uint32_t rounds,
+                   const ResultStore &store,
+                   unsigned jobs,
+                   ostream &os)
+{
+  const char *classes[] = {"Center", "Edge", "Random"};
+  uint16_t classUes[] = {base.numCenterUes, base.numEdgeUes, base.numRandomUes};
+  // per algorithm: the results of every offered load [Mbps] run so far
+  vector<map<double, vector<FlowGoodput> > > results (algos.size ());
+  auto keepsUp = [&] (const vector<FlowGoodput> &r, int c, double load) -> bool
+  {
+    return GetClassMean (r, classes[c]) / 1000000 >= fraction * load
+           && GetClassDelay (r, classes[c]) <= maxDelay.GetSeconds ();
+  };
+  // highest load class c keeps up with and the next load, 0 when there is none
+  auto getBracket = [&] (size_t a, int c) -> pair<double, double>
+  {
+    pair<double, double> bracket (0.0, 0.0);
+    for (map<double, vector<FlowGoodput> >::const_iterator it = results[a].begin (); it != results[a].end (); ++it)
+      {
+        if (!keepsUp (it->second, c, it->first))
+          {
+            bracket.second = it->first;
+            break;
+          }
+        bracket.first = it->first;
+      }
+    return bracket;
+  };
+
+  vector<set<double> > pending (algos.size ());
+  for (uint32_t p = 0; p < points; ++p)
+    {
+      double load = points > 1 ? minMbps * pow (maxMbps / minMbps, double (p) / (points - 1)) : maxMbps;
+      for (size_t a = 0; a < algos.size (); ++a)
+        {
+          pending[a].insert (load);
+        }
+    }
+
+  os << "round,algo,offeredMbps,class,goodputMbps,goodputRatio,delayMs,keepsUp\n";
+  for (uint32_t round = 0; round <= rounds; ++round)
+    {
+      vector<ScenarioConfig> configs;
+      vector<pair<size_t, double> > loads;
+      for (size_t a = 0; a < algos.size (); ++a)
+        {
+          for (set<double>::const_iterator it = pending[a].begin (); it != pending[a].end (); ++it)
+            {
+              if (results[a].count (*it) == 0)
+                {
+                  ScenarioConfig config = base;
+                  config.algo = algos[a];
+                  config.interPacketInterval = Seconds (UL_PACKET_SIZE * 8 / (*it * 1000000));
+                  configs.push_back (config);
+                  loads.push_back (make_pair (a, *it));
+                }
+            }
+          pending[a].clear ();
+        }
+      if (configs.empty ())
+        {
+          break;
+        }
+      ostringstream what;
+      what << "load points of round " << round;
+      vector<SimProcessPool::JobResult> runs =
+        RunStoredScenarios (configs, vector<uint32_t> (configs.size (), RngSeedManager::GetRun ()), store, jobs, what.str ());
+
+      for (size_t i = 0; i < runs.size (); ++i)
+        {
+          size_t a = loads[i].first;
+          double load = loads[i].second;
+          if (!runs[i].Ok ())
+            {
+              cerr << "Run " << i << " of round " << round << " (" << algos[a] << ", " << load
+                   << " Mbps) failed with status " << runs[i].status << endl;
+              continue;
+            }
+          vector<FlowGoodput> &r = results[a][load];
+          r = ReadGoodputs (runs[i].output);
+          for (int c = 0; c < 3; ++c)
+            {
+              if (classUes[c] == 0)
+                {
+                  continue;
+                }
+              double goodput = GetClassMean (r, classes[c]) / 1000000;
+              os << round << "," << algos[a] << "," << load << "," << classes[c] << "," << goodput
+                 << "," << goodput / load << "," << GetClassDelay (r, classes[c]) * 1000
+                 << "," << keepsUp (r, c, load) << "\n";
+            }
+        }
+
+      // refine the brackets
+      for (size_t a = 0; a < algos.size (); ++a)
+        {
+          for (int c = 0; c < 3; ++c)
+            {
+              pair<double, double> bracket = getBracket (a, c);
+              if (classUes[c] == 0 || bracket.first == 0 || bracket.second == 0)
+                {
+                  continue;
+                }
+              for (uint32_t p = 1; p <= points; ++p)
+                {
+                  pending[a].insert (bracket.first * pow (bracket.second / bracket.first, double (p) / (points + 1)));
+                }
+            }
+        }
+    }
+
+  cout << "algo\tclass\tcapacityMbps\tfailsAtMbps\n";
+  for (size_t a = 0; a < algos.size (); ++a)
+    {
+      for (int c = 0; c < 3; ++c)
+        {
+          if (classUes[c] == 0)
+            {
+              continue;
+            }
+          pair<double, double> bracket = getBracket (a, c);
+          cout << algos[a] << "\t" << classes[c] << "\t";
+          if (bracket.first == 0)
+            {
+              cout << "<" << minMbps;
+            }
+          else
+            {
+              cout << bracket.first;
+            }
+          cout << "\t";
+          if (bracket.second == 0)
+            {
+              cout << ">" << maxMbps;
+            }
+          else
+            {
+              cout << bracket.second;
+            }
+          cout << "\n";
+        }
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  ScenarioConfig config;
+  config.simTime = 4.0;
+  config.distance = 1000.0;
+  config.interPacketInterval = MilliSeconds (10);
+  config.numCenterUes = 1;
+  config.numEdgeUes = 1;
+  config.numRandomUes = 1;
+  config.algo = "NoOp";
+  config.seed = 42;
+  config.enableTraces = true;
+  config.binaryTraces = false;
+  config.compressTraces = false;
+  config.goodputWindow = Seconds (0);
+  config.goodputOutput = "goodput-series.csv";
+  config.hexRings = 0;
+  config.wrapAround = false;
+  config.pathlossCache = true;
+  config.cullingMarginDb = -1;
+  config.scheduler = "ns3::PfFfMacScheduler";
+  config.schedulerCost = false;
+  config.stopHalfWidth = 0;
+  config.stopBatch = MilliSeconds (100);
+  config.stopMinBatches = 10;
+  config.confidence = 0.95;
+  config.warmupDetection = false;
+  config.warmupWindow = MilliSeconds (50);
+  config.maxPackets = 10000;
+
+  bool sweep = false;
+  string sweepAlgos;
+  string sweepCenterUes;
+  string sweepEdgeUes;
+  string sweepRandomUes;
+  string sweepSeeds;
+  string sweepOutput = "sweep-results.csv";
+  uint32_t jobs = 0;
+  string warmStartRuns;
+  string warmStartIntervals;
+  string warmStartOutput = "warm-start-results.csv";
+  bool shootout = false;
+  string shootoutSchedulers;
+  string shootoutOutput = "shootout-results.csv";
+  string resultStoreDir;
+  bool capacity = false;
+  string capacityAlgos = "NoOp,Hard,Strict";
+  double capacityFraction = 0.95;
+  Time capacityMaxDelay = MilliSeconds (100);
+  double capacityMinMbps = 0.05;
+  double capacityMaxMbps = 5;
+  uint32_t capacityPoints = 8;
+  uint32_t capacityRounds = 2;
+  string capacityOutput = "capacity-results.csv";
+  uint32_t replications = 0;
+  uint32_t firstRun = 0;
+  string replicationOutput = "replication-results.csv";
+
+  // Command line arguments
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("numCenterUes", "Number of center UEs per cell", config.numCenterUes);
+  cmd.AddValue ("numEdgeUes", "Number of edge UEs per cell", config.numEdgeUes);
+  cmd.AddValue ("numRandomUes", "Number of random UEs per cell", config.numRandomUes);
+  cmd.AddValue ("simTime", "Total duration of the simulation", config.simTime);
+  cmd.AddValue ("distance", "Distance between eNBs [m]", config.distance);
+  cmd.AddValue ("interPacketInterval", "Inter packet interval", config.interPacketInterval);
+  cmd.AddValue ("maxPackets", "Packets sent by every UE, 0 for as many as simTime allows", config.maxPackets);
+  cmd.AddValue ("algo", "Algorithim", config.algo);
+  cmd.AddValue ("hexRings", "Rings of hexagonal sites around a central one, "
+                "0 for the original three cells", config.hexRings);
+  cmd.AddValue ("wrapAround", "Wrap the interference around the hexagonal layout", config.wrapAround);
+  cmd.AddValue ("pathlossCache", "Precompute the pathloss of static nodes and cache the others", config.pathlossCache);
+  cmd.AddValue ("cullingMarginDb", "Drop signals more than this below the noise floor in each RB, "
+                "negative to deliver every signal", config.cullingMarginDb);
+  cmd.AddValue ("scheduler", "FF MAC scheduler, e.g. Pf, Rr or ns3::PssFfMacScheduler", config.scheduler);
+  cmd.AddValue ("schedulerCost", "Measure the scheduler wall time and allocations", config.schedulerCost);
+  cmd.AddValue ("stopHalfWidth", "Stop before simTime once the CI half width of every class goodput, "
+                "relative to its mean, is below this, e.g. 0.05; 0 always runs to simTime", config.stopHalfWidth);
+  cmd.AddValue ("stopBatch", "Batch length of the early stopping batch means", config.stopBatch);
+  cmd.AddValue ("stopMinBatches", "Batches needed before stopping early", config.stopMinBatches);
+  cmd.AddValue ("warmupDetection", "Detect the warm-up of every flow with MSER-5 and measure "
+                "its goodput from there instead of from 0.5 s", config.warmupDetection);
+  cmd.AddValue ("warmupWindow", "Window of the throughput series of the warm-up detection", config.warmupWindow);
+  cmd.AddValue ("seed", "Seed of the random number generator", config.seed);
+  cmd.AddValue ("traces", "Enable the LTE stats traces", config.enableTraces);
+  cmd.AddValue ("binaryTraces", "Write the LTE stats traces in binary columnar format", config.binaryTraces);
+  cmd.AddValue ("compressTraces", "Compress the binary traces with zstd", config.compressTraces);
+  cmd.AddValue ("goodputWindow", "Window of the per-flow goodput series, 0 disables it", config.goodputWindow);
+  cmd.AddValue ("goodputOutput", "CSV file receiving the goodput series (one per run in a sweep)", config.goodputOutput);
+  cmd.AddValue ("sweep", "Run a parameter sweep instead of a single scenario", sweep);
+  cmd.AddValue ("sweepAlgos", "Comma separated algorithms to sweep (default: algo)", sweepAlgos);
+  cmd.AddValue ("sweepCenterUes", "Comma separated numCenterUes values to sweep", sweepCenterUes);
+  cmd.AddValue ("sweepEdgeUes", "Comma separated numEdgeUes values to sweep", sweepEdgeUes);
+  cmd.AddValue ("sweepRandomUes", "Comma separated numRandomUes values to sweep", sweepRandomUes);
+  cmd.AddValue ("sweepSeeds", "Comma separated seeds to sweep (default: seed)", sweepSeeds);
+  cmd.AddValue ("sweepOutput", "File receiving the merged sweep results", sweepOutput);
+  cmd.AddValue ("jobs", "Maximum number of parallel runs, 0 for one per CPU", jobs);
+  cmd.AddValue ("capacity", "Search the highest offered load per UE every class keeps up with, per algorithm", capacity);
+  cmd.AddValue ("capacityAlgos", "Comma separated algorithms of the capacity search", capacityAlgos);
+  cmd.AddValue ("capacityFraction", "Fraction of the offered load a class must receive to keep up", capacityFraction);
+  cmd.AddValue ("capacityMaxDelay", "Highest mean packet delay of a class that keeps up", capacityMaxDelay);
+  cmd.AddValue ("capacityMinMbps", "Lowest offered load per UE of the capacity search [Mbps]", capacityMinMbps);
+  cmd.AddValue ("capacityMaxMbps", "Highest offered load per UE of the capacity search [Mbps]", capacityMaxMbps);
+  cmd.AddValue ("capacityPoints", "Loads run in parallel per algorithm in every round of the capacity search", capacityPoints);
+  cmd.AddValue ("capacityRounds", "Refinement rounds of the capacity search after the initial ramp", capacityRounds);
+  cmd.AddValue ("capacityOutput", "File receiving every run of the capacity search", capacityOutput);
+  cmd.AddValue ("resultStore", "Directory of memoized results: runs without traces whose scenario, "
+                "defaults and binary are unchanged are read from it instead of simulated", resultStoreDir);
+  cmd.AddValue ("warmStartRuns", "Comma separated RNG run numbers to fork after a shared warm-up", warmStartRuns);
+  cmd.AddValue ("warmStartIntervals", "Comma separated inter packet intervals (e.g. 10ms) "
+                "to fork after a shared warm-up", warmStartIntervals);
+  cmd.AddValue ("warmStartOutput", "File receiving the warm-started results", warmStartOutput);
+  cmd.AddValue ("shootout", "Run the scenario under every scheduler and compare them", shootout);
+  cmd.AddValue ("shootoutSchedulers", "Comma separated schedulers of the shootout (default: all)", shootoutSchedulers);
+  cmd.AddValue ("shootoutOutput", "File receiving the per-run shootout results", shootoutOutput);
+  cmd.AddValue ("replications", "Run this many independent replications in parallel "
+                "and report confidence intervals, 0 disables it", replications);
+  cmd.AddValue ("firstRun", "RNG run number of the first replication, 0 for the current RngRun", firstRun);
+  cmd.AddValue ("confidence", "Level of the replication and early stopping confidence intervals", config.confidence);
+  cmd.AddValue ("replicationOutput", "File receiving the replication statistics", replicationOutput);
+  cmd.Parse (argc, argv);
+
+  ConfigStore inputConfig;
+  inputConfig.ConfigureDefaults ();
+
+  // parse again so you can override default values from the command line
+  cmd.Parse(argc, argv);
+  config.scheduler = GetSchedulerType (config.scheduler);
+
+  if (shootout)
+    {
+      // every run would write the same trace files in the working directory
+      config.enableTraces = false;
+      config.goodputWindow = Seconds (0);
+      vector<string> schedulers = SplitList (shootoutSchedulers);
+      if (schedulers.empty ())
+        {
+          schedulers.assign (ALL_SCHEDULERS, ALL_SCHEDULERS + sizeof (ALL_SCHEDULERS) / sizeof (ALL_SCHEDULERS[0]));
+        }
+      for (size_t k = 0; k < schedulers.size (); ++k)
+        {
+          schedulers[k] = GetSchedulerType (schedulers[k]);
+        }
+      vector<uint32_t> seeds = sweepSeeds.empty () ? vector<uint32_t> (1, config.seed) : SplitUintList (sweepSeeds);
+
+      ofstream out (shootoutOutput.c_str ());
+      if (!out.is_open ())
+        {
+          NS_FATAL_ERROR ("Can't open file " << shootoutOutput);
+        }
+      RunSchedulerShootout (config, schedulers, seeds, jobs, out);
+      cout << "Shootout results written to " << shootoutOutput << "\n";
+      return 0;
+    }
+
+  if (capacity)
+    {
+      // every run would write the same trace files in the working directory
+      config.enableTraces = false;
+      config.goodputWindow = Seconds (0);
+      // the offered load must not run out of packets
+      config.maxPackets = 0;
+
+      ofstream out (capacityOutput.c_str ());
+      if (!out.is_open ())
+        {
+          NS_FATAL_ERROR ("Can't open file " << capacityOutput);
+        }
+      RunCapacitySearch (config, SplitList (capacityAlgos), capacityFraction, capacityMaxDelay,
+                         capacityMinMbps, capacityMaxMbps, max<uint32_t> (capacityPoints, 1), capacityRounds,
+                         ResultStore (resultStoreDir), jobs, out);
+      cout << "Capacity search results written to " << capacityOutput << "\n";
+      return 0;
+    }
+
+  if (replications > 0)
+    {
+      // every replication would write the same trace files in the working directory
+      config.enableTraces = false;
+      config.goodputWindow = Seconds (0);
+      if (firstRun == 0)
+        {
+          firstRun = RngSeedManager::GetRun ();
+        }
+
+      ofstream out (replicationOutput.c_str ());
+      if (!out.is_open ())
+        {
+          NS_FATAL_ERROR ("Can't open file " << replicationOutput);
+        }
+      RunReplications (config, replications, firstRun, config.confidence, ResultStore (resultStoreDir), jobs, out);
+      cout << "Replication results written to " << replicationOutput << "\n";
+      return 0;
+    }
+
+  if (!warmStartRuns.empty () || !warmStartIntervals.empty ())
+    {
+      // the children would share the trace files opened during the warm-up
+      config.enableTraces = false;
+      config.goodputWindow = Seconds (0);
+      vector<uint32_t> runs = warmStartRuns.empty () ? vector<uint32_t> (1, RngSeedManager::GetRun ()) : SplitUintList (warmStartRuns);
+      vector<Time> intervals;
+      vector<string> intervalList = SplitList (warmStartIntervals);
+      for (size_t i = 0; i < intervalList.size (); ++i)
+        {
+          intervals.push_back (Time (intervalList[i]));
+        }
+      if (intervals.empty ())
+        {
+          intervals.push_back (config.interPacketInterval);
+        }
+      vector<WarmStartVariant> variants;
+      for (size_t r = 0; r < runs.size (); ++r)
+        for (size_t i = 0; i < intervals.size (); ++i)
+          {
+            WarmStartVariant variant = {runs[r], intervals[i]};
+            variants.push_back (variant);
+          }
+
+      ofstream out (warmStartOutput.c_str ());
+      if (!out.is_open ())
+        {
+          NS_FATAL_ERROR ("Can't open file " << warmStartOutput);
+        }
+      vector<vector<FlowGoodput> > results = RunScenario (config, variants, jobs);
+      out << "variant,run,interPacketInterval,enb,class,flow,goodputMbps\n";
+      for (size_t v = 0; v < variants.size (); ++v)
+        {
+          ostringstream prefix;
+          prefix << v << "," << variants[v].run << "," << variants[v].interPacketInterval.GetSeconds ();
+          WriteGoodputTable (out, prefix.str (), results[v], GetNumberOfCells (config));
+        }
+      cout << "Warm-started results written to " << warmStartOutput << "\n";
+      return 0;
+    }
+
+  if (!sweep)
+    {
+      ResultStore store (resultStoreDir);
+      string scenario = DescribeScenario (config, RngSeedManager::GetRun ());
+      string stored;
+      vector<FlowGoodput> results;
+      if (IsStorable (config) && store.Lookup (scenario, stored))
+        {
+          cerr << "Result read from the result store" << endl;
+          results = ReadGoodputs (stored);
+        }
+      else
+        {
+          results = RunScenario (config);
+          if (IsStorable (config))
+            {
+              ostringstream out;
+              WriteGoodputs (out, results);
+              store.Store (scenario, out.str ());
+            }
+        }
+      PrintGoodputReport (results, GetNumberOfCells (config), config.warmupDetection);
+      if (config.schedulerCost)
+        {
+          const SchedulerCost &cost = TimedFfMacScheduler::GetTotalCost ();
+          double ttis = max<double> (cost.dlTriggers, 1);
+          cout << "Scheduler " << config.scheduler << ": " << cost.seconds * 1e6 / ttis << " us, "
+               << cost.dlAllocations / ttis << " DL and " << cost.ulAllocations / ttis
+               << " UL allocations per cell and TTI\n";
+        }
+      return 0;
+    }
+
+  // every run would write the same trace files in the working directory
+  config.enableTraces = false;
+  vector<string> algos = sweepAlgos.empty () ? vector<string> (1, config.algo) : SplitList (sweepAlgos);
+  vector<uint32_t> centerUes = sweepCenterUes.empty () ? vector<uint32_t> (1, config.numCenterUes) : SplitUintList (sweepCenterUes);
+  vector<uint32_t> edgeUes = sweepEdgeUes.empty () ? vector<uint32_t> (1, config.numEdgeUes) : SplitUintList (sweepEdgeUes);
+  vector<uint32_t> randomUes = sweepRandomUes.empty () ? vector<uint32_t> (1, config.numRandomUes) : SplitUintList (sweepRandomUes);
+  vector<uint32_t> seeds = sweepSeeds.empty () ? vector<uint32_t> (1, config.seed) : SplitUintList (sweepSeeds);
+
+  ofstream out (sweepOutput.c_str ());
+  if (!out.is_open ())
+    {
+      NS_FATAL_ERROR ("Can't open file " << sweepOutput);
+    }
+  RunSweep (config, algos, centerUes, edgeUes, randomUes, seeds, ResultStore (resultStoreDir), jobs, out);
+  cout << "Sweep results written to " << sweepOutput << "\n";
 
   return 0;
 }
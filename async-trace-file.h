@@ -0,0 +1,255 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef ASYNC_TRACE_FILE_H
+#define ASYNC_TRACE_FILE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Output file written by a background thread.
+ *
+ * The simulator thread hands whole buffers to Write (), which swaps them
+ * into a single-producer, single-consumer ring without taking a lock;
+ * the writer thread drains the ring to the file, so the simulation only
+ * waits for the disk when the ring is full.  Buffers come back to the
+ * producer emptied but with their capacity, so in steady state no buffer
+ * is allocated.
+ *
+ * A file name ending in ".zst" is compressed on the fly by piping it
+ * through the zstd command line tool.  Without zstd the data is written
+ * uncompressed, to the name without ".zst".
+ */
+class AsyncTraceFile
+{
+public:
+  /**
+   * \param filename file to write, compressed if it ends in ".zst"
+   * \param capacity number of buffers the ring holds
+   */
+  explicit AsyncTraceFile (const std::string &filename, size_t capacity = 64)
+    : m_file (0),
+      m_pipe (false),
+      m_ring (capacity),
+      m_head (0),
+      m_tail (0),
+      m_closing (false)
+  {
+    std::string name = filename;
+    if (IsCompressed (name))
+      {
+        if (HasZstd ())
+          {
+            m_file = popen (("zstd -q -f -o " + Quote (name)).c_str (), "w");
+            m_pipe = true;
+          }
+        else
+          {
+            name.resize (name.size () - 4);
+            std::cerr << "zstd not found, writing " << name << " uncompressed" << std::endl;
+          }
+      }
+    if (!m_pipe)
+      {
+        m_file = std::fopen (name.c_str (), "wb");
+      }
+    if (m_file)
+      {
+        m_thread = std::thread (&AsyncTraceFile::Run, this);
+      }
+  }
+
+  ~AsyncTraceFile ()
+  {
+    Close ();
+  }
+
+  bool IsOpen () const
+  {
+    return m_file != 0;
+  }
+
+  /// Queue data for writing; data is left empty, possibly with a reused capacity
+  void Write (std::vector<uint8_t> &data)
+  {
+    if (!m_file || data.empty ())
+      {
+        data.clear ();
+        return;
+      }
+    size_t head = m_head.load (std::memory_order_relaxed);
+    while (head - m_tail.load (std::memory_order_acquire) == m_ring.size ())
+      {
+        // the ring is full: the disk is slower than the simulation
+        std::this_thread::yield ();
+      }
+    m_ring[head % m_ring.size ()].swap (data);
+    m_head.store (head + 1, std::memory_order_release);
+    m_wake.notify_one ();
+    data.clear ();
+  }
+
+  /// Write everything queued and close the file
+  void Close ()
+  {
+    if (!m_file)
+      {
+        return;
+      }
+    m_closing.store (true, std::memory_order_release);
+    m_wake.notify_one ();
+    m_thread.join ();
+    if (m_pipe)
+      {
+        pclose (m_file);
+      }
+    else
+      {
+        std::fclose (m_file);
+      }
+    m_file = 0;
+  }
+
+  static bool IsCompressed (const std::string &filename)
+  {
+    return filename.size () > 4 && filename.compare (filename.size () - 4, 4, ".zst") == 0;
+  }
+
+  /// \return true if the zstd command line tool can be run
+  static bool HasZstd ()
+  {
+    static bool hasZstd = std::system ("zstd --version > /dev/null 2>&1") == 0;
+    return hasZstd;
+  }
+
+  /// \return filename quoted for the shell
+  static std::string Quote (const std::string &filename)
+  {
+    std::string quoted = "'";
+    for (size_t i = 0; i < filename.size (); ++i)
+      {
+        quoted += filename[i] == '\'' ? std::string ("'\\''") : std::string (1, filename[i]);
+      }
+    return quoted + "'";
+  }
+
+private:
+  AsyncTraceFile (const AsyncTraceFile &);
+  AsyncTraceFile &operator= (const AsyncTraceFile &);
+
+  void Run ()
+  {
+    while (true)
+      {
+        size_t tail = m_tail.load (std::memory_order_relaxed);
+        if (tail == m_head.load (std::memory_order_acquire))
+          {
+            // the producer sets m_closing after its last Write ()
+            if (m_closing.load (std::memory_order_acquire) && tail == m_head.load (std::memory_order_acquire))
+              {
+                break;
+              }
+            // a notification can be missed, so only sleep for a while
+            std::unique_lock<std::mutex> lock (m_mutex);
+            m_wake.wait_for (lock, std::chrono::milliseconds (10));
+            continue;
+          }
+        std::vector<uint8_t> &buffer = m_ring[tail % m_ring.size ()];
+        std::fwrite (buffer.data (), 1, buffer.size (), m_file);
+        buffer.clear ();
+        m_tail.store (tail + 1, std::memory_order_release);
+      }
+    std::fflush (m_file);
+  }
+
+  FILE *m_file;
+  bool m_pipe;
+  std::vector<std::vector<uint8_t> > m_ring;
+  std::atomic<size_t> m_head; ///< buffers queued so far, only written by the producer
+  std::atomic<size_t> m_tail; ///< buffers written so far, only written by the writer thread
+  std::atomic<bool> m_closing;
+  std::mutex m_mutex;         ///< only protects the sleep of the writer thread
+  std::condition_variable m_wake;
+  std::thread m_thread;
+};
+
+/**
+ * Input file that transparently decompresses names ending in ".zst"
+ * through the zstd command line tool.
+ */
+class TraceInputFile
+{
+public:
+  explicit TraceInputFile (const std::string &filename)
+    : m_pipe (AsyncTraceFile::IsCompressed (filename)),
+      m_ok (false)
+  {
+    m_file = m_pipe ? popen (("zstd -q -d -c " + AsyncTraceFile::Quote (filename)).c_str (), "r")
+                    : std::fopen (filename.c_str (), "rb");
+    m_ok = m_file != 0;
+  }
+
+  ~TraceInputFile ()
+  {
+    if (m_file && m_pipe)
+      {
+        pclose (m_file);
+      }
+    else if (m_file)
+      {
+        std::fclose (m_file);
+      }
+  }
+
+  bool IsOpen () const
+  {
+    return m_file != 0;
+  }
+
+  /// Read n bytes to data; \return false, also from then on, if they are not all there
+  bool Read (void *data, size_t n)
+  {
+    m_ok = m_ok && std::fread (data, 1, n, m_file) == n;
+    return m_ok;
+  }
+
+  bool IsOk () const
+  {
+    return m_ok;
+  }
+
+private:
+  TraceInputFile (const TraceInputFile &);
+  TraceInputFile &operator= (const TraceInputFile &);
+
+  FILE *m_file;
+  bool m_pipe;
+  bool m_ok;
+};
+
+#endif /* ASYNC_TRACE_FILE_H */
@@ -0,0 +1,393 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef BINARY_TRACE_FORMAT_H
+#define BINARY_TRACE_FORMAT_H
+
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "async-trace-file.h"
+
+/*
+ * Columnar binary trace file layout (host byte order):
+ *
+ *   char[8]  magic "LTEBTRC1"
+ *   uint32   byte order marker 0x01020304
+ *   uint16   table name length, followed by the name
+ *   uint16   number of columns
+ *   per column:
+ *     uint8  column type (BinaryTraceColumn::Type)
+ *     uint16 column name length, followed by the name
+ *   chunks until end of file:
+ *     uint32 number of rows N
+ *     per column: N fixed-width values, stored contiguously
+ *
+ * A file whose name ends in ".zst" holds the same layout as a zstd stream.
+ */
+
+/// One typed column of a binary trace table
+struct BinaryTraceColumn
+{
+  enum Type
+  {
+    U8 = 1,
+    U16 = 2,
+    U32 = 3,
+    U64 = 4,
+    F64 = 5
+  };
+
+  BinaryTraceColumn (const std::string &n, Type t)
+    : name (n),
+      type (t)
+  {
+  }
+
+  /// \return the width of one value of this column in bytes
+  size_t GetWidth () const
+  {
+    switch (type)
+      {
+      case U8:
+        return 1;
+      case U16:
+        return 2;
+      case U32:
+        return 4;
+      default:
+        return 8;
+      }
+  }
+
+  std::string name;
+  Type type;
+};
+
+static const char BINARY_TRACE_MAGIC[8] = {'L', 'T', 'E', 'B', 'T', 'R', 'C', '1'};
+static const uint32_t BINARY_TRACE_BYTE_ORDER = 0x01020304;
+
+/**
+ * Writes one table of fixed-width typed columns.  Rows are buffered and
+ * written one column after the other every chunkRows rows, so that no
+ * formatting happens on the hot path; the chunks are written, and
+ * compressed for a ".zst" file name, by the thread of an AsyncTraceFile.
+ *
+ * Usage: w.Add (time).Add (cellId).Add (sinr); w.EndRow ();
+ */
+class BinaryTraceWriter
+{
+public:
+  BinaryTraceWriter (const std::string &filename, const std::string &table,
+                     const std::vector<BinaryTraceColumn> &columns, uint32_t chunkRows = 4096)
+    : m_file (filename),
+      m_columns (columns),
+      m_buffers (columns.size ()),
+      m_chunkRows (chunkRows),
+      m_rows (0),
+      m_col (0)
+  {
+    if (!m_file.IsOpen ())
+      {
+        return;
+      }
+    m_out.insert (m_out.end (), BINARY_TRACE_MAGIC, BINARY_TRACE_MAGIC + sizeof (BINARY_TRACE_MAGIC));
+    WritePod (BINARY_TRACE_BYTE_ORDER);
+    WriteString (table);
+    WritePod (static_cast<uint16_t> (m_columns.size ()));
+    for (size_t i = 0; i < m_columns.size (); ++i)
+      {
+        WritePod (static_cast<uint8_t> (m_columns[i].type));
+        WriteString (m_columns[i].name);
+        m_buffers[i].reserve (m_chunkRows * m_columns[i].GetWidth ());
+      }
+    m_file.Write (m_out);
+  }
+
+  ~BinaryTraceWriter ()
+  {
+    Close ();
+  }
+
+  bool IsOpen () const
+  {
+    return m_file.IsOpen ();
+  }
+
+  /// Set the next column of the current row; the value is converted to the column type
+  template <typename T>
+  BinaryTraceWriter &Add (T v)
+  {
+    const BinaryTraceColumn &c = m_columns[m_col];
+    std::vector<uint8_t> &b = m_buffers[m_col];
+    switch (c.type)
+      {
+      case BinaryTraceColumn::U8:
+        Append (b, static_cast<uint8_t> (v));
+        break;
+      case BinaryTraceColumn::U16:
+        Append (b, static_cast<uint16_t> (v));
+        break;
+      case BinaryTraceColumn::U32:
+        Append (b, static_cast<uint32_t> (v));
+        break;
+      case BinaryTraceColumn::U64:
+        Append (b, static_cast<uint64_t> (v));
+        break;
+      case BinaryTraceColumn::F64:
+        Append (b, static_cast<double> (v));
+        break;
+      }
+    ++m_col;
+    return *this;
+  }
+
+  /// Terminate the current row; every column must have been set
+  void EndRow ()
+  {
+    m_col = 0;
+    if (++m_rows == m_chunkRows)
+      {
+        Flush ();
+      }
+  }
+
+  /// Write the buffered rows as one chunk
+  void Flush ()
+  {
+    if (m_rows == 0 || !m_file.IsOpen ())
+      {
+        return;
+      }
+    WritePod (m_rows);
+    for (size_t i = 0; i < m_buffers.size (); ++i)
+      {
+        m_out.insert (m_out.end (), m_buffers[i].begin (), m_buffers[i].end ());
+        m_buffers[i].clear ();
+      }
+    m_file.Write (m_out);
+    m_rows = 0;
+  }
+
+  void Close ()
+  {
+    if (m_file.IsOpen ())
+      {
+        Flush ();
+        m_file.Close ();
+      }
+  }
+
+private:
+  template <typename T>
+  static void Append (std::vector<uint8_t> &b, T v)
+  {
+    size_t n = b.size ();
+    b.resize (n + sizeof (T));
+    std::memcpy (&b[n], &v, sizeof (T));
+  }
+
+  template <typename T>
+  void WritePod (T v)
+  {
+    Append (m_out, v);
+  }
+
+  void WriteString (const std::string &s)
+  {
+    WritePod (static_cast<uint16_t> (s.size ()));
+    m_out.insert (m_out.end (), s.begin (), s.end ());
+  }
+
+  AsyncTraceFile m_file;
+  std::vector<uint8_t> m_out; ///< bytes handed to m_file, recycled by it
+  std::vector<BinaryTraceColumn> m_columns;
+  std::vector<std::vector<uint8_t> > m_buffers;
+  uint32_t m_chunkRows;
+  uint32_t m_rows;
+  size_t m_col;
+};
+
+/**
+ * Reads a table written by BinaryTraceWriter one chunk at a time.
+ *
+ * Usage: while (r.NextChunk ()) for (row < r.GetRows ()) r.GetDouble (col, row);
+ */
+class BinaryTraceReader
+{
+public:
+  explicit BinaryTraceReader (const std::string &filename)
+    : m_file (filename),
+      m_ok (false),
+      m_rows (0)
+  {
+    if (!m_file.IsOpen ())
+      {
+        return;
+      }
+    char magic[sizeof (BINARY_TRACE_MAGIC)];
+    uint32_t byteOrder = 0;
+    m_file.Read (magic, sizeof (magic));
+    ReadPod (byteOrder);
+    if (!m_file.IsOk () || std::memcmp (magic, BINARY_TRACE_MAGIC, sizeof (magic)) != 0
+        || byteOrder != BINARY_TRACE_BYTE_ORDER)
+      {
+        return;
+      }
+    m_table = ReadString ();
+    uint16_t nColumns = 0;
+    ReadPod (nColumns);
+    for (uint16_t i = 0; i < nColumns && m_file.IsOk (); ++i)
+      {
+        uint8_t type = 0;
+        ReadPod (type);
+        std::string name = ReadString ();
+        m_columns.push_back (BinaryTraceColumn (name, static_cast<BinaryTraceColumn::Type> (type)));
+      }
+    m_data.resize (m_columns.size ());
+    m_ok = m_file.IsOk ();
+  }
+
+  /// \return false if the file is missing, truncated or not a binary trace
+  bool IsOk () const
+  {
+    return m_ok;
+  }
+
+  const std::string &GetTable () const
+  {
+    return m_table;
+  }
+
+  const std::vector<BinaryTraceColumn> &GetColumns () const
+  {
+    return m_columns;
+  }
+
+  /// \return the index of the named column, or -1
+  int FindColumn (const std::string &name) const
+  {
+    for (size_t i = 0; i < m_columns.size (); ++i)
+      {
+        if (m_columns[i].name == name)
+          {
+            return static_cast<int> (i);
+          }
+      }
+    return -1;
+  }
+
+  /// Load the next chunk; \return false at end of file
+  bool NextChunk ()
+  {
+    if (!m_ok)
+      {
+        return false;
+      }
+    m_rows = 0;
+    if (!ReadPod (m_rows))
+      {
+        return false;
+      }
+    for (size_t i = 0; i < m_columns.size (); ++i)
+      {
+        m_data[i].resize (static_cast<size_t> (m_rows) * m_columns[i].GetWidth ());
+        m_file.Read (m_data[i].data (), m_data[i].size ());
+      }
+    if (!m_file.IsOk ())
+      {
+        m_ok = false;
+        m_rows = 0;
+        return false;
+      }
+    return true;
+  }
+
+  /// \return the number of rows of the current chunk
+  uint32_t GetRows () const
+  {
+    return m_rows;
+  }
+
+  /// \return the value at (col, row) of the current chunk, for integer columns
+  uint64_t GetUint (size_t col, uint32_t row) const
+  {
+    const uint8_t *p = &m_data[col][row * m_columns[col].GetWidth ()];
+    switch (m_columns[col].type)
+      {
+      case BinaryTraceColumn::U8:
+        return Load<uint8_t> (p);
+      case BinaryTraceColumn::U16:
+        return Load<uint16_t> (p);
+      case BinaryTraceColumn::U32:
+        return Load<uint32_t> (p);
+      case BinaryTraceColumn::U64:
+        return Load<uint64_t> (p);
+      default:
+        return static_cast<uint64_t> (Load<double> (p));
+      }
+  }
+
+  /// \return the value at (col, row) of the current chunk, for any column
+  double GetDouble (size_t col, uint32_t row) const
+  {
+    if (m_columns[col].type == BinaryTraceColumn::F64)
+      {
+        return Load<double> (&m_data[col][row * 8]);
+      }
+    return static_cast<double> (GetUint (col, row));
+  }
+
+private:
+  template <typename T>
+  static T Load (const uint8_t *p)
+  {
+    T v;
+    std::memcpy (&v, p, sizeof (T));
+    return v;
+  }
+
+  template <typename T>
+  bool ReadPod (T &v)
+  {
+    return m_file.Read (&v, sizeof (T));
+  }
+
+  std::string ReadString ()
+  {
+    uint16_t n = 0;
+    ReadPod (n);
+    std::string s (n, '\0');
+    if (n > 0)
+      {
+        m_file.Read (&s[0], n);
+      }
+    return s;
+  }
+
+  TraceInputFile m_file;
+  bool m_ok;
+  std::string m_table;
+  std::vector<BinaryTraceColumn> m_columns;
+  std::vector<std::vector<uint8_t> > m_data;
+  uint32_t m_rows;
+};
+
+#endif /* BINARY_TRACE_FORMAT_H */
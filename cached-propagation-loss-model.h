@@ -0,0 +1,272 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef CACHED_PROPAGATION_LOSS_MODEL_H
+#define CACHED_PROPAGATION_LOSS_MODEL_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/propagation-module.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Propagation loss model that caches the gain computed by another one.
+ *
+ * The spectrum channel asks for the loss of every transmission towards
+ * every receiver, although most nodes never move.  Precompute () stores
+ * the gain between static (ConstantPositionMobilityModel) transmitters
+ * and receivers in two dense matrices, one per direction; a node leaves
+ * the matrices as soon as it reports a course change.  Every other pair
+ * goes through a hash table tagged with the positions of both ends, and
+ * is recomputed only when one of them has moved.
+ *
+ * The wrapped model, of type ModelType, must be deterministic and its
+ * received power must be the transmitted power minus a loss, which holds
+ * for the deterministic models of the propagation module.  Frequency is
+ * forwarded to it, so the model can be used as the LteHelper pathloss
+ * model; other attributes of the wrapped model are set through
+ * Config::SetDefault.
+ */
+class CachedPropagationLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::CachedPropagationLossModel")
+      .SetParent<PropagationLossModel> ()
+      .AddConstructor<CachedPropagationLossModel> ()
+      .AddAttribute ("ModelType", "Type of the wrapped propagation loss model",
+                     StringValue ("ns3::FriisPropagationLossModel"),
+                     MakeStringAccessor (&CachedPropagationLossModel::m_modelType),
+                     MakeStringChecker ())
+      .AddAttribute ("Frequency", "Carrier frequency, forwarded to the wrapped model [Hz]",
+                     DoubleValue (2160e6),
+                     MakeDoubleAccessor (&CachedPropagationLossModel::SetFrequency,
+                                         &CachedPropagationLossModel::GetFrequency),
+                     MakeDoubleChecker<double> ())
+    ;
+    return tid;
+  }
+
+  CachedPropagationLossModel ()
+    : m_frequency (2160e6),
+      m_hits (0),
+      m_misses (0)
+  {
+  }
+
+  void SetFrequency (double frequency)
+  {
+    m_frequency = frequency;
+    if (m_model)
+      {
+        m_model->SetAttributeFailSafe ("Frequency", DoubleValue (frequency));
+      }
+    Clear ();
+  }
+
+  double GetFrequency () const
+  {
+    return m_frequency;
+  }
+
+  /**
+   * Fill the matrices with the gain between the static nodes of txNodes
+   * and those of rxNodes, in both directions.  Call it once the nodes
+   * have their final position, and after the frequency has been set.
+   */
+  void Precompute (NodeContainer txNodes, NodeContainer rxNodes)
+  {
+    Clear ();
+    for (uint32_t i = 0; i < txNodes.GetN (); ++i)
+      {
+        Ptr<MobilityModel> m = txNodes.Get (i)->GetObject<MobilityModel> ();
+        if (DynamicCast<ConstantPositionMobilityModel> (m) && m_rows.count (PeekPointer (m)) == 0)
+          {
+            m_rows[PeekPointer (m)] = m_rowModels.size ();
+            m_rowModels.push_back (m);
+          }
+      }
+    for (uint32_t j = 0; j < rxNodes.GetN (); ++j)
+      {
+        Ptr<MobilityModel> m = rxNodes.Get (j)->GetObject<MobilityModel> ();
+        if (DynamicCast<ConstantPositionMobilityModel> (m) && m_columns.count (PeekPointer (m)) == 0)
+          {
+            m_columns[PeekPointer (m)] = m_columnModels.size ();
+            m_columnModels.push_back (m);
+          }
+      }
+
+    size_t nColumns = m_columnModels.size ();
+    m_forward.resize (m_rowModels.size () * nColumns);
+    m_reverse.resize (m_rowModels.size () * nColumns);
+    for (size_t r = 0; r < m_rowModels.size (); ++r)
+      {
+        for (size_t c = 0; c < nColumns; ++c)
+          {
+            m_forward[r * nColumns + c] = GetModel ()->CalcRxPower (0.0, m_rowModels[r], m_columnModels[c]);
+            m_reverse[r * nColumns + c] = GetModel ()->CalcRxPower (0.0, m_columnModels[c], m_rowModels[r]);
+          }
+      }
+
+    // a static node that is moved anyway falls back to the position-tagged cache
+    for (size_t r = 0; r < m_rowModels.size (); ++r)
+      {
+        m_rowModels[r]->TraceConnectWithoutContext ("CourseChange",
+                                                   MakeCallback (&CachedPropagationLossModel::Moved, this));
+      }
+    for (size_t c = 0; c < m_columnModels.size (); ++c)
+      {
+        m_columnModels[c]->TraceConnectWithoutContext ("CourseChange",
+                                                      MakeCallback (&CachedPropagationLossModel::Moved, this));
+      }
+  }
+
+  /// \return the number of gains served from the matrices or the cache
+  uint64_t GetHits () const
+  {
+    return m_hits;
+  }
+
+  /// \return the number of gains computed by the wrapped model
+  uint64_t GetMisses () const
+  {
+    return m_misses;
+  }
+
+private:
+  /// gain of a non-static pair, valid while both ends stay where they were
+  struct Entry
+  {
+    Vector a;
+    Vector b;
+    double gainDb;
+    bool valid;
+  };
+
+  struct PairHash
+  {
+    size_t operator() (const std::pair<const MobilityModel *, const MobilityModel *> &p) const
+    {
+      return std::hash<const void *> () (p.first) * 31 + std::hash<const void *> () (p.second);
+    }
+  };
+
+  typedef std::unordered_map<const MobilityModel *, size_t> IndexMap;
+  typedef std::unordered_map<std::pair<const MobilityModel *, const MobilityModel *>, Entry, PairHash> EntryMap;
+
+  Ptr<PropagationLossModel> GetModel () const
+  {
+    if (!m_model)
+      {
+        ObjectFactory factory;
+        factory.SetTypeId (m_modelType);
+        m_model = factory.Create<PropagationLossModel> ();
+        m_model->SetAttributeFailSafe ("Frequency", DoubleValue (m_frequency));
+      }
+    return m_model;
+  }
+
+  void Clear ()
+  {
+    m_rows.clear ();
+    m_columns.clear ();
+    m_rowModels.clear ();
+    m_columnModels.clear ();
+    m_forward.clear ();
+    m_reverse.clear ();
+    m_entries.clear ();
+  }
+
+  void Moved (Ptr<const MobilityModel> model)
+  {
+    m_rows.erase (PeekPointer (model));
+    m_columns.erase (PeekPointer (model));
+  }
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    size_t nColumns = m_columnModels.size ();
+    IndexMap::const_iterator ra = m_rows.find (PeekPointer (a));
+    if (ra != m_rows.end ())
+      {
+        IndexMap::const_iterator cb = m_columns.find (PeekPointer (b));
+        if (cb != m_columns.end ())
+          {
+            ++m_hits;
+            return txPowerDbm + m_forward[ra->second * nColumns + cb->second];
+          }
+      }
+    IndexMap::const_iterator ca = m_columns.find (PeekPointer (a));
+    if (ca != m_columns.end ())
+      {
+        IndexMap::const_iterator rb = m_rows.find (PeekPointer (b));
+        if (rb != m_rows.end ())
+          {
+            ++m_hits;
+            return txPowerDbm + m_reverse[rb->second * nColumns + ca->second];
+          }
+      }
+
+    Vector pa = a->GetPosition ();
+    Vector pb = b->GetPosition ();
+    Entry &e = m_entries[std::make_pair (PeekPointer (a), PeekPointer (b))];
+    if (e.valid
+        && e.a.x == pa.x && e.a.y == pa.y && e.a.z == pa.z
+        && e.b.x == pb.x && e.b.y == pb.y && e.b.z == pb.z)
+      {
+        ++m_hits;
+        return txPowerDbm + e.gainDb;
+      }
+    ++m_misses;
+    e.a = pa;
+    e.b = pb;
+    e.valid = true;
+    e.gainDb = GetModel ()->CalcRxPower (0.0, a, b);
+    return txPowerDbm + e.gainDb;
+  }
+
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return GetModel ()->AssignStreams (stream);
+  }
+
+  std::string m_modelType;
+  double m_frequency;
+  mutable Ptr<PropagationLossModel> m_model;
+  IndexMap m_rows;
+  IndexMap m_columns;
+  std::vector<Ptr<MobilityModel> > m_rowModels;
+  std::vector<Ptr<MobilityModel> > m_columnModels;
+  std::vector<double> m_forward; ///< gain [dB] from row to column node
+  std::vector<double> m_reverse; ///< gain [dB] from column to row node
+  mutable EntryMap m_entries;
+  mutable uint64_t m_hits;
+  mutable uint64_t m_misses;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+
+} // namespace ns3
+
+#endif /* CACHED_PROPAGATION_LOSS_MODEL_H */
@@ -0,0 +1,281 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef ENB_SPATIAL_INDEX_H
+#define ENB_SPATIAL_INDEX_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/lte-module.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Uniform grid over the (x, y) positions of a set of eNBs.
+ *
+ * The grid has about one eNB per bucket, so nearest-eNB, k-nearest and
+ * radius queries look at a few buckets around the query point instead of
+ * every eNB.  Queries search rings of buckets of growing size and stop
+ * once no unvisited bucket can hold a closer eNB; distances are computed
+ * in 3D, as in LteHelper::AttachToClosestEnb.  The index is static: build
+ * it once the eNBs have their final position.
+ */
+class EnbSpatialIndex
+{
+public:
+  /// Index the given positions; results are indices into positions
+  explicit EnbSpatialIndex (const std::vector<Vector> &positions)
+  {
+    Build (positions);
+  }
+
+  /// Index the positions of enbDevs; results are indices into enbDevs
+  explicit EnbSpatialIndex (NetDeviceContainer enbDevs)
+    : m_enbDevs (enbDevs)
+  {
+    std::vector<Vector> positions;
+    for (uint32_t i = 0; i < enbDevs.GetN (); ++i)
+      {
+        positions.push_back (enbDevs.Get (i)->GetNode ()->GetObject<MobilityModel> ()->GetPosition ());
+      }
+    Build (positions);
+  }
+
+  uint32_t GetN () const
+  {
+    return m_positions.size ();
+  }
+
+  /// \return the index of the eNB closest to p
+  uint32_t FindClosest (const Vector &p) const
+  {
+    NS_ASSERT (!m_positions.empty ());
+    return FindKNearest (p, 1)[0];
+  }
+
+  /// \return the indices of the k eNBs closest to p, closest first
+  std::vector<uint32_t> FindKNearest (const Vector &p, uint32_t k) const
+  {
+    k = std::min<uint32_t> (k, m_positions.size ());
+    // max-heap of the best k so far
+    std::priority_queue<std::pair<double, uint32_t> > best;
+    int cx = ClampX (p.x);
+    int cy = ClampY (p.y);
+    for (int r = 0; ; ++r)
+      {
+        for (int bx = cx - r; bx <= cx + r; ++bx)
+          {
+            for (int by = cy - r; by <= cy + r; ++by)
+              {
+                // only the outline of the ring, the inside was visited before
+                if (std::abs (bx - cx) != r && std::abs (by - cy) != r)
+                  {
+                    continue;
+                  }
+                if (bx < 0 || by < 0 || bx >= m_nx || by >= m_ny)
+                  {
+                    continue;
+                  }
+                const std::vector<uint32_t> &bucket = m_buckets[by * m_nx + bx];
+                for (size_t i = 0; i < bucket.size (); ++i)
+                  {
+                    double d = CalculateDistance (p, m_positions[bucket[i]]);
+                    if (best.size () < k)
+                      {
+                        best.push (std::make_pair (d, bucket[i]));
+                      }
+                    else if (d < best.top ().first)
+                      {
+                        best.pop ();
+                        best.push (std::make_pair (d, bucket[i]));
+                      }
+                  }
+              }
+          }
+        bool coversGrid = cx - r <= 0 && cy - r <= 0 && cx + r >= m_nx - 1 && cy + r >= m_ny - 1;
+        if (coversGrid || (best.size () == k && best.top ().first <= GetVisitedMargin (p, cx, cy, r)))
+          {
+            break;
+          }
+      }
+    std::vector<uint32_t> result (best.size ());
+    for (size_t i = result.size (); i > 0; --i)
+      {
+        result[i - 1] = best.top ().second;
+        best.pop ();
+      }
+    return result;
+  }
+
+  /// \return the indices of the eNBs within radius of p, in no particular order
+  std::vector<uint32_t> FindWithin (const Vector &p, double radius) const
+  {
+    std::vector<uint32_t> result;
+    int x0 = ClampX (p.x - radius);
+    int x1 = ClampX (p.x + radius);
+    int y0 = ClampY (p.y - radius);
+    int y1 = ClampY (p.y + radius);
+    for (int by = y0; by <= y1; ++by)
+      {
+        for (int bx = x0; bx <= x1; ++bx)
+          {
+            const std::vector<uint32_t> &bucket = m_buckets[by * m_nx + bx];
+            for (size_t i = 0; i < bucket.size (); ++i)
+              {
+                if (CalculateDistance (p, m_positions[bucket[i]]) <= radius)
+                  {
+                    result.push_back (bucket[i]);
+                  }
+              }
+          }
+      }
+    return result;
+  }
+
+  /**
+   * Attach every UE to the closest eNB, like LteHelper::AttachToClosestEnb;
+   * the index must have been built from the eNB devices.
+   */
+  void AttachToClosestEnb (Ptr<LteHelper> lteHelper, NetDeviceContainer ueDevs) const
+  {
+    NS_ASSERT (m_enbDevs.GetN () == m_positions.size ());
+    for (uint32_t i = 0; i < ueDevs.GetN (); ++i)
+      {
+        Vector p = ueDevs.Get (i)->GetNode ()->GetObject<MobilityModel> ()->GetPosition ();
+        lteHelper->Attach (ueDevs.Get (i), m_enbDevs.Get (FindClosest (p)));
+      }
+  }
+
+  /**
+   * Add an X2 interface between every eNB and its k closest neighbours,
+   * instead of between every pair as LteHelper::AddX2Interface does; the
+   * index must have been built from the eNB devices.
+   */
+  void AddX2Interfaces (Ptr<LteHelper> lteHelper, uint32_t k) const
+  {
+    NS_ASSERT (m_enbDevs.GetN () == m_positions.size ());
+    std::set<std::pair<uint32_t, uint32_t> > added;
+    for (uint32_t i = 0; i < m_positions.size (); ++i)
+      {
+        // the closest one is the eNB itself
+        std::vector<uint32_t> neighbours = FindKNearest (m_positions[i], k + 1);
+        for (size_t n = 0; n < neighbours.size (); ++n)
+          {
+            uint32_t j = neighbours[n];
+            if (j != i && added.insert (std::make_pair (std::min (i, j), std::max (i, j))).second)
+              {
+                lteHelper->AddX2Interface (m_enbDevs.Get (i)->GetNode (), m_enbDevs.Get (j)->GetNode ());
+              }
+          }
+      }
+  }
+
+private:
+  void Build (const std::vector<Vector> &positions)
+  {
+    m_positions = positions;
+    m_xMin = m_yMin = std::numeric_limits<double>::max ();
+    double xMax = -std::numeric_limits<double>::max ();
+    double yMax = -std::numeric_limits<double>::max ();
+    for (size_t i = 0; i < positions.size (); ++i)
+      {
+        m_xMin = std::min (m_xMin, positions[i].x);
+        m_yMin = std::min (m_yMin, positions[i].y);
+        xMax = std::max (xMax, positions[i].x);
+        yMax = std::max (yMax, positions[i].y);
+      }
+    if (positions.empty ())
+      {
+        m_xMin = m_yMin = xMax = yMax = 0;
+      }
+    // about one eNB per bucket
+    double area = std::max (xMax - m_xMin, 1.0) * std::max (yMax - m_yMin, 1.0);
+    m_bucketSize = std::sqrt (area / std::max<size_t> (positions.size (), 1));
+    m_nx = static_cast<int> ((xMax - m_xMin) / m_bucketSize) + 1;
+    m_ny = static_cast<int> ((yMax - m_yMin) / m_bucketSize) + 1;
+    m_buckets.assign (m_nx * m_ny, std::vector<uint32_t> ());
+    for (uint32_t i = 0; i < positions.size (); ++i)
+      {
+        m_buckets[ClampY (positions[i].y) * m_nx + ClampX (positions[i].x)].push_back (i);
+      }
+  }
+
+  int ClampX (double x) const
+  {
+    return std::min (std::max (static_cast<int> (std::floor ((x - m_xMin) / m_bucketSize)), 0), m_nx - 1);
+  }
+
+  int ClampY (double y) const
+  {
+    return std::min (std::max (static_cast<int> (std::floor ((y - m_yMin) / m_bucketSize)), 0), m_ny - 1);
+  }
+
+  /**
+   * \return a lower bound of the distance from p to any bucket outside
+   * the (2r + 1) x (2r + 1) square of buckets around (cx, cy)
+   */
+  double GetVisitedMargin (const Vector &p, int cx, int cy, int r) const
+  {
+    double x0 = m_xMin + (cx - r) * m_bucketSize;
+    double x1 = m_xMin + (cx + r + 1) * m_bucketSize;
+    double y0 = m_yMin + (cy - r) * m_bucketSize;
+    double y1 = m_yMin + (cy + r + 1) * m_bucketSize;
+    // buckets beyond the grid are empty, so those sides do not count
+    double margin = std::numeric_limits<double>::infinity ();
+    if (cx - r > 0)
+      {
+        margin = std::min (margin, p.x - x0);
+      }
+    if (cx + r < m_nx - 1)
+      {
+        margin = std::min (margin, x1 - p.x);
+      }
+    if (cy - r > 0)
+      {
+        margin = std::min (margin, p.y - y0);
+      }
+    if (cy + r < m_ny - 1)
+      {
+        margin = std::min (margin, y1 - p.y);
+      }
+    return margin;
+  }
+
+  NetDeviceContainer m_enbDevs;
+  std::vector<Vector> m_positions;
+  double m_xMin;
+  double m_yMin;
+  double m_bucketSize;
+  int m_nx;
+  int m_ny;
+  std::vector<std::vector<uint32_t> > m_buckets; ///< eNB indices, row major
+};
+
+} // namespace ns3
+
+#endif /* ENB_SPATIAL_INDEX_H */
@@ -0,0 +1,202 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef GOODPUT_CONVERGENCE_H
+#define GOODPUT_CONVERGENCE_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/applications-module.h>
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "replication-stats.h"
+
+namespace ns3 {
+
+/**
+ * Stops the simulation once the per-class goodput has converged.
+ *
+ * Every batch, the bytes received by the sinks of each UE class are
+ * turned into one batch-mean goodput of that class.  Once there are at
+ * least minBatches batches and, for every class, the half width of the
+ * Student-t confidence interval of the batch means is at most
+ * relativeHalfWidth times their mean, Simulator::Stop () is called.  The
+ * stop time given to Start () is a hard cap: without convergence the
+ * simulation ends there as before.  The sinks are read at the batch
+ * boundaries only, so nothing is added to the packet path.
+ *
+ * With warm-up detection, the first batches of every class are dropped
+ * as its transient, at the truncation point MSER picks on the batch
+ * series so far, so that the transient neither biases the estimate nor
+ * delays the stop by widening the interval.
+ */
+class GoodputConvergenceMonitor : public SimpleRefCount<GoodputConvergenceMonitor>
+{
+public:
+  /**
+   * \param batch length of a batch
+   * \param start start of the first batch, usually when the sinks start
+   * \param relativeHalfWidth target CI half width relative to the mean
+   * \param confidence level of the confidence intervals
+   * \param minBatches batches needed before the intervals are trusted
+   */
+  GoodputConvergenceMonitor (Time batch, Time start, double relativeHalfWidth,
+                             double confidence = 0.95, uint32_t minBatches = 10)
+    : m_batch (batch),
+      m_start (start),
+      m_relativeHalfWidth (relativeHalfWidth),
+      m_confidence (confidence),
+      m_minBatches (minBatches),
+      m_warmupDetection (false),
+      m_converged (false)
+  {
+    NS_ABORT_MSG_IF (!batch.IsStrictlyPositive (), "the batch length must be positive");
+  }
+
+  /// Count the bytes received by sink, a PacketSink, in ueClass
+  void AddFlow (Ptr<Application> sink, const std::string &ueClass)
+  {
+    Class &c = m_classes[ueClass];
+    c.sinks.push_back (DynamicCast<PacketSink> (sink));
+  }
+
+  /// Drop the warm-up batches of every class, as detected by MSER
+  void SetWarmupDetection (bool enable)
+  {
+    m_warmupDetection = enable;
+  }
+
+  /// Schedule the batches up to the hard cap stop; call before Simulator::Run ()
+  void Start (Time stop)
+  {
+    m_stop = stop;
+    Simulator::Schedule (m_start - Simulator::Now (), &GoodputConvergenceMonitor::EndBatch, this);
+  }
+
+  /// \return true if the simulation was stopped by convergence
+  bool HasConverged () const
+  {
+    return m_converged;
+  }
+
+  /// Print the batch statistics of every class
+  void Report (std::ostream &os) const
+  {
+    os << (m_converged ? "Goodput converged" : "Goodput did not converge")
+       << " at " << Simulator::Now ().GetSeconds () << " s:";
+    for (std::map<std::string, Class>::const_iterator it = m_classes.begin (); it != m_classes.end (); ++it)
+      {
+        size_t warmup = GetWarmupBatches (it->second);
+        SampleStats s = GetStats (it->second, warmup);
+        os << " " << it->first << " " << s.GetMean () / 1000000 << " +- "
+           << s.GetCiHalfWidth (m_confidence) / 1000000 << " Mbps (" << s.GetN () << " batches";
+        if (m_warmupDetection)
+          {
+            os << " after " << warmup << " warm-up batches";
+          }
+        os << ")";
+      }
+    os << std::endl;
+  }
+
+private:
+  struct Class
+  {
+    Class ()
+      : lastBytes (0)
+    {
+    }
+    std::vector<Ptr<PacketSink> > sinks;
+    uint64_t lastBytes;          ///< bytes received at the end of the last batch
+    std::vector<double> batches; ///< batch-mean goodputs [bit/s]
+  };
+
+  size_t GetWarmupBatches (const Class &c) const
+  {
+    return m_warmupDetection ? GetMserTruncation (c.batches, 1) : 0;
+  }
+
+  /// \return the statistics of the batches of c after the first warmup ones
+  static SampleStats GetStats (const Class &c, size_t warmup)
+  {
+    SampleStats s;
+    for (size_t i = warmup; i < c.batches.size (); ++i)
+      {
+        s.Add (c.batches[i]);
+      }
+    return s;
+  }
+
+  void EndBatch ()
+  {
+    bool converged = !m_classes.empty ();
+    for (std::map<std::string, Class>::iterator it = m_classes.begin (); it != m_classes.end (); ++it)
+      {
+        Class &c = it->second;
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < c.sinks.size (); ++i)
+          {
+            bytes += c.sinks[i]->GetTotalRx ();
+          }
+        // the first call only marks the start of the first batch
+        if (Simulator::Now () > m_start)
+          {
+            c.batches.push_back ((bytes - c.lastBytes) * 8 / m_batch.GetSeconds ());
+          }
+        c.lastBytes = bytes;
+        SampleStats s = GetStats (c, GetWarmupBatches (c));
+        converged = converged && s.GetN () >= m_minBatches
+          && s.GetCiHalfWidth (m_confidence) <= m_relativeHalfWidth * std::fabs (s.GetMean ());
+      }
+
+    if (converged)
+      {
+        m_converged = true;
+        Simulator::Stop ();
+      }
+    else if (Simulator::Now () + m_batch < m_stop)
+      {
+        Simulator::Schedule (m_batch, &GoodputConvergenceMonitor::EndBatch, this);
+      }
+    else if (Simulator::Now () + m_batch == m_stop)
+      {
+        // the Stop event of the cap was scheduled first: end the last batch
+        // one time step early so that it runs before it
+        Simulator::Schedule (m_batch - TimeStep (1), &GoodputConvergenceMonitor::EndBatch, this);
+      }
+  }
+
+  Time m_batch;
+  Time m_start;
+  Time m_stop;
+  double m_relativeHalfWidth;
+  double m_confidence;
+  uint32_t m_minBatches;
+  bool m_warmupDetection;
+  bool m_converged;
+  std::map<std::string, Class> m_classes;
+};
+
+} // namespace ns3
+
+#endif /* GOODPUT_CONVERGENCE_H */
@@ -0,0 +1,185 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef GOODPUT_MONITOR_H
+#define GOODPUT_MONITOR_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/applications-module.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Streaming per-flow goodput time series.
+ *
+ * Counts the bytes every monitored PacketSink receives through its Rx
+ * trace and, at the end of every window, writes one CSV row per flow and
+ * one per (eNB, class) and per eNB sum:
+ *
+ *   time,enb,class,flow,windowMbps,cumulativeMbps
+ *
+ * time is the end of the window, windowMbps the goodput within it and
+ * cumulativeMbps the goodput from the start of the measurement to time;
+ * class and eNB sums use "sum" as flow, the eNB sums "EnB" as class.  Only
+ * the byte counters of the current window are kept, so memory does not
+ * grow with the simulated time.
+ */
+class GoodputMonitor : public SimpleRefCount<GoodputMonitor>
+{
+public:
+  /**
+   * \param filename CSV file receiving the series
+   * \param window length of a window
+   * \param start start of the first window, usually when the sinks start
+   */
+  GoodputMonitor (const std::string &filename, Time window, Time start)
+    : m_out (filename.c_str ()),
+      m_window (window),
+      m_start (start)
+  {
+    NS_ABORT_MSG_IF (!m_out.is_open (), "Can't open file " << filename);
+    NS_ABORT_MSG_IF (!window.IsStrictlyPositive (), "the goodput window must be positive");
+    m_out << "time,enb,class,flow,windowMbps,cumulativeMbps\n";
+  }
+
+  /// Monitor the flow received by sink
+  void AddFlow (Ptr<Application> sink, uint32_t enb, const std::string &ueClass, uint32_t flow)
+  {
+    Flow f;
+    f.enb = enb;
+    f.ueClass = ueClass;
+    f.flow = flow;
+    f.windowBytes = 0;
+    f.totalBytes = 0;
+    m_flows.push_back (f);
+    sink->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&GoodputMonitor::Rx, this, m_flows.size () - 1));
+  }
+
+  /// Monitor the flows of sinks, numbered from 0 in container order
+  void AddFlows (ApplicationContainer sinks, uint32_t enb, const std::string &ueClass)
+  {
+    for (uint32_t j = 0; j < sinks.GetN (); ++j)
+      {
+        AddFlow (sinks.Get (j), enb, ueClass, j);
+      }
+  }
+
+  /// Schedule the windows up to stop; call before Simulator::Run ()
+  void Start (Time stop)
+  {
+    m_stop = stop;
+    m_windowEnd = m_start + m_window;
+    ScheduleWindowEnd ();
+  }
+
+private:
+  struct Flow
+  {
+    uint32_t enb;
+    std::string ueClass;
+    uint32_t flow;
+    uint64_t windowBytes;
+    uint64_t totalBytes;
+  };
+
+  static void Rx (GoodputMonitor *monitor, size_t flow, Ptr<const Packet> packet, const Address &from)
+  {
+    monitor->m_flows[flow].windowBytes += packet->GetSize ();
+  }
+
+  /**
+   * Schedule the end of the window ending at m_windowEnd.  The Stop event
+   * of the run is scheduled first, so a window ending at the stop time is
+   * closed one time step early to run before it.
+   */
+  void ScheduleWindowEnd ()
+  {
+    Time delay = m_windowEnd - Simulator::Now ();
+    Simulator::Schedule (m_windowEnd < m_stop ? delay : delay - TimeStep (1), &GoodputMonitor::EndWindow, this);
+  }
+
+  void EndWindow ()
+  {
+    double windowSeconds = m_window.GetSeconds ();
+    double elapsedSeconds = (m_windowEnd - m_start).GetSeconds ();
+    // (enb, class) -> (window bytes, total bytes); "EnB" holds the eNB sums
+    std::map<std::pair<uint32_t, std::string>, std::pair<uint64_t, uint64_t> > sums;
+    for (size_t i = 0; i < m_flows.size (); ++i)
+      {
+        Flow &f = m_flows[i];
+        f.totalBytes += f.windowBytes;
+        WriteRow (f.enb, f.ueClass, "", f.flow, f.windowBytes * 8 / windowSeconds, f.totalBytes * 8 / elapsedSeconds);
+        std::pair<uint64_t, uint64_t> &c = sums[std::make_pair (f.enb, f.ueClass)];
+        c.first += f.windowBytes;
+        c.second += f.totalBytes;
+        std::pair<uint64_t, uint64_t> &e = sums[std::make_pair (f.enb, std::string ("EnB"))];
+        e.first += f.windowBytes;
+        e.second += f.totalBytes;
+        f.windowBytes = 0;
+      }
+    for (std::map<std::pair<uint32_t, std::string>, std::pair<uint64_t, uint64_t> >::iterator it = sums.begin ();
+         it != sums.end (); ++it)
+      {
+        WriteRow (it->first.first, it->first.second, "sum", 0,
+                  it->second.first * 8 / windowSeconds, it->second.second * 8 / elapsedSeconds);
+      }
+
+    m_windowEnd += m_window;
+    if (m_windowEnd <= m_stop)
+      {
+        ScheduleWindowEnd ();
+      }
+    else
+      {
+        m_out.flush ();
+      }
+  }
+
+  void WriteRow (uint32_t enb, const std::string &ueClass, const char *sum, uint32_t flow,
+                 double windowGoodput, double cumulativeGoodput)
+  {
+    m_out << m_windowEnd.GetSeconds () << "," << enb << "," << ueClass << ",";
+    if (*sum)
+      {
+        m_out << sum;
+      }
+    else
+      {
+        m_out << flow;
+      }
+    m_out << "," << windowGoodput / 1000000 << "," << cumulativeGoodput / 1000000 << "\n";
+  }
+
+  std::ofstream m_out;
+  Time m_window;
+  Time m_start;
+  Time m_stop;
+  Time m_windowEnd; ///< end of the current window
+  std::vector<Flow> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* GOODPUT_MONITOR_H */
@@ -0,0 +1,319 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef HEX_TOPOLOGY_H
+#define HEX_TOPOLOGY_H
+
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/propagation-module.h>
+
+#include <cmath>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Hexagonal grid of single-cell sites: a central site and the given
+ * number of rings around it, 1 + 3 * rings * (rings + 1) cells in total.
+ *
+ * Cells are numbered ring by ring.  The first three are the layout of
+ * the original three-cell scenarios, (0, 0), (distance, 0) and
+ * (distance / 2, -distance * sqrt (3) / 2), and the FrCellTypeId of every
+ * cell follows a reuse-3 pattern where no two neighbours share a type.
+ * Cells are the Voronoi hexagons of the sites, with their vertices at
+ * 30 + 60 k degrees and distance / sqrt (3) from the site.
+ */
+class HexTopology
+{
+public:
+  /**
+   * \param rings number of rings around the central site
+   * \param distance inter-site distance [m]
+   */
+  HexTopology (uint32_t rings, double distance)
+    : m_rings (rings),
+      m_distance (distance)
+  {
+    m_cells.push_back (Axial (0, 0));
+    // walk each ring from (k, 0) along the six sides
+    static const int dirs[6][2] = {{0, -1}, {-1, 0}, {-1, 1}, {0, 1}, {1, 0}, {1, -1}};
+    for (int k = 1; k <= static_cast<int> (rings); ++k)
+      {
+        Axial a (k, 0);
+        for (int side = 0; side < 6; ++side)
+          {
+            for (int step = 0; step < k; ++step)
+              {
+                m_cells.push_back (a);
+                a.q += dirs[side][0];
+                a.r += dirs[side][1];
+              }
+          }
+      }
+  }
+
+  uint32_t GetNCells () const
+  {
+    return m_cells.size ();
+  }
+
+  uint32_t GetRings () const
+  {
+    return m_rings;
+  }
+
+  double GetDistance () const
+  {
+    return m_distance;
+  }
+
+  /// \return the position of the site of cell, at height z
+  Vector GetSitePosition (uint32_t cell, double z = 0.0) const
+  {
+    return ToVector (m_cells[cell], z);
+  }
+
+  /// \return the reuse-3 FrCellTypeId of cell, 1 to 3
+  uint8_t GetCellTypeId (uint32_t cell) const
+  {
+    // (q - r) changes by 1 or 2 towards every neighbour, never by 0 or 3
+    int t = (m_cells[cell].q - m_cells[cell].r) % 3;
+    return (t < 0 ? t + 3 : t) + 1;
+  }
+
+  /// \return vertex j mod 6 of the hexagon of cell, the cell edge where three cells meet
+  Vector GetEdgePosition (uint32_t cell, uint32_t j, double z = 0.0) const
+  {
+    double angle = M_PI / 6 + (j % 6) * M_PI / 3;
+    double radius = m_distance / std::sqrt (3.0);
+    Vector site = GetSitePosition (cell, z);
+    return Vector (site.x + radius * std::cos (angle), site.y + radius * std::sin (angle), z);
+  }
+
+  /// \return the bounding box of the hexagon of cell, at height z
+  Box GetCellBounds (uint32_t cell, double z) const
+  {
+    Vector site = GetSitePosition (cell);
+    double radius = m_distance / std::sqrt (3.0);
+    return Box (site.x - m_distance / 2, site.x + m_distance / 2, site.y - radius, site.y + radius, z, z);
+  }
+
+  /// \return the bounding box of all cells, at height z
+  Box GetBounds (double z) const
+  {
+    Box box = GetCellBounds (0, z);
+    for (uint32_t i = 1; i < m_cells.size (); ++i)
+      {
+        Box c = GetCellBounds (i, z);
+        box.xMin = std::min (box.xMin, c.xMin);
+        box.xMax = std::max (box.xMax, c.xMax);
+        box.yMin = std::min (box.yMin, c.yMin);
+        box.yMax = std::max (box.yMax, c.yMax);
+      }
+    return box;
+  }
+
+  /**
+   * \return the six translations that tile the plane with copies of the
+   * whole layout, used for wrap-around
+   */
+  std::vector<Vector> GetWrapShifts () const
+  {
+    std::vector<Vector> shifts;
+    int n = m_rings;
+    // (2n + 1, -n) and its rotations by 60 degrees: (q, r) -> (-r, q + r)
+    Axial a (2 * n + 1, -n);
+    for (int k = 0; k < 6; ++k)
+      {
+        shifts.push_back (ToVector (a, 0.0));
+        a = Axial (-a.r, a.q + a.r);
+      }
+    return shifts;
+  }
+
+private:
+  /// axial hexagonal coordinates
+  struct Axial
+  {
+    Axial (int q, int r)
+      : q (q),
+        r (r)
+    {
+    }
+    int q;
+    int r;
+  };
+
+  Vector ToVector (Axial a, double z) const
+  {
+    return Vector (m_distance * (a.q + a.r * 0.5), m_distance * a.r * std::sqrt (3.0) / 2, z);
+  }
+
+  uint32_t m_rings;
+  double m_distance;
+  std::vector<Axial> m_cells;
+};
+
+/**
+ * Wrap-around for a HexTopology: the loss between two nodes is the loss
+ * computed by the wrapped model towards the nearest of the seven copies
+ * of the transmitter (the original and its images across the six
+ * borders), so cells on the outer ring see as many interferers as the
+ * central one.  The reuse-3 pattern cannot line up across the borders,
+ * since no hexagonal layout of this kind has a multiple of 3 cells, so a
+ * few outer cells see a co-type neighbour through the wrap.
+ *
+ * Use it as the pathloss model of the LteHelper and set Rings and
+ * Distance to those of the topology; Frequency is forwarded to the
+ * wrapped model, a FriisPropagationLossModel unless Model is set.
+ */
+class HexWrapAroundPropagationLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::HexWrapAroundPropagationLossModel")
+      .SetParent<PropagationLossModel> ()
+      .AddConstructor<HexWrapAroundPropagationLossModel> ()
+      .AddAttribute ("Rings", "Number of rings of the hexagonal layout",
+                     UintegerValue (1),
+                     MakeUintegerAccessor (&HexWrapAroundPropagationLossModel::SetRings,
+                                           &HexWrapAroundPropagationLossModel::GetRings),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("Distance", "Inter-site distance of the hexagonal layout [m]",
+                     DoubleValue (500.0),
+                     MakeDoubleAccessor (&HexWrapAroundPropagationLossModel::SetDistance,
+                                         &HexWrapAroundPropagationLossModel::GetDistance),
+                     MakeDoubleChecker<double> (0.0))
+      .AddAttribute ("Frequency", "Carrier frequency, forwarded to the wrapped model [Hz]",
+                     DoubleValue (2160e6),
+                     MakeDoubleAccessor (&HexWrapAroundPropagationLossModel::SetFrequency,
+                                         &HexWrapAroundPropagationLossModel::GetFrequency),
+                     MakeDoubleChecker<double> ())
+      .AddAttribute ("Model", "The wrapped propagation loss model",
+                     PointerValue (),
+                     MakePointerAccessor (&HexWrapAroundPropagationLossModel::m_model),
+                     MakePointerChecker<PropagationLossModel> ())
+    ;
+    return tid;
+  }
+
+  HexWrapAroundPropagationLossModel ()
+    : m_rings (1),
+      m_distance (500.0),
+      m_frequency (2160e6),
+      m_image (CreateObject<ConstantPositionMobilityModel> ())
+  {
+    UpdateShifts ();
+  }
+
+  void SetRings (uint32_t rings)
+  {
+    m_rings = rings;
+    UpdateShifts ();
+  }
+
+  uint32_t GetRings () const
+  {
+    return m_rings;
+  }
+
+  void SetDistance (double distance)
+  {
+    m_distance = distance;
+    UpdateShifts ();
+  }
+
+  double GetDistance () const
+  {
+    return m_distance;
+  }
+
+  void SetFrequency (double frequency)
+  {
+    m_frequency = frequency;
+    if (m_model)
+      {
+        m_model->SetAttributeFailSafe ("Frequency", DoubleValue (frequency));
+      }
+  }
+
+  double GetFrequency () const
+  {
+    return m_frequency;
+  }
+
+private:
+  void UpdateShifts ()
+  {
+    m_shifts = HexTopology (m_rings, m_distance).GetWrapShifts ();
+  }
+
+  Ptr<PropagationLossModel> GetModel () const
+  {
+    if (!m_model)
+      {
+        m_model = CreateObject<FriisPropagationLossModel> ();
+        m_model->SetAttributeFailSafe ("Frequency", DoubleValue (m_frequency));
+      }
+    return m_model;
+  }
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    Vector pa = a->GetPosition ();
+    Vector pb = b->GetPosition ();
+    Vector nearest = pa;
+    double best = CalculateDistance (pa, pb);
+    for (size_t k = 0; k < m_shifts.size (); ++k)
+      {
+        Vector image (pa.x + m_shifts[k].x, pa.y + m_shifts[k].y, pa.z);
+        double d = CalculateDistance (image, pb);
+        if (d < best)
+          {
+            best = d;
+            nearest = image;
+          }
+      }
+    if (nearest.x == pa.x && nearest.y == pa.y)
+      {
+        return GetModel ()->CalcRxPower (txPowerDbm, a, b);
+      }
+    m_image->SetPosition (nearest);
+    return GetModel ()->CalcRxPower (txPowerDbm, m_image, b);
+  }
+
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return GetModel ()->AssignStreams (stream);
+  }
+
+  uint32_t m_rings;
+  double m_distance;
+  double m_frequency;
+  mutable Ptr<PropagationLossModel> m_model;
+  Ptr<ConstantPositionMobilityModel> m_image;
+  std::vector<Vector> m_shifts;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (HexWrapAroundPropagationLossModel);
+
+} // namespace ns3
+
+#endif /* HEX_TOPOLOGY_H */
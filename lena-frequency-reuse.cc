@@ -28,6 +28,19 @@
 #include <ns3/spectrum-module.h>
 #include <ns3/log.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+#include <unistd.h>
+
+#include "enb-spatial-index.h"
+#include "lte-binary-traces.h"
+#include "lte-fast-error-model.h"
+#include "lte-rem-cube.h"
+#include "sim-process-pool.h"
+#include "spectrum-analyzer-trace.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("LenaFrequencyReuse");
@@ -75,6 +88,115 @@ PrintGnuplottableNodeListToFile (std::string filename)
     outFile << "plot \"lena-frequency-reuse.rem\" using ($1):($2):(10*log10($4)) with image" << std::endl;
 }
 
+/**
+ * Configure a REM helper for the columns xMin..xMax (xRes steps) of the
+ * grid and for the full y range of box (yRes steps).
+ */
+void
+ConfigureRemHelper (Ptr<RadioEnvironmentMapHelper> remHelper, std::string outputFile,
+                    double xMin, double xMax, uint16_t xRes, Box box, uint16_t yRes, int32_t remRbId)
+{
+  remHelper->SetAttribute ("ChannelPath", StringValue ("/ChannelList/0"));
+  remHelper->SetAttribute ("OutputFile", StringValue (outputFile));
+  remHelper->SetAttribute ("XMin", DoubleValue (xMin));
+  remHelper->SetAttribute ("XMax", DoubleValue (xMax));
+  remHelper->SetAttribute ("YMin", DoubleValue (box.yMin));
+  remHelper->SetAttribute ("YMax", DoubleValue (box.yMax));
+  remHelper->SetAttribute ("Z", DoubleValue (1.5));
+  remHelper->SetAttribute ("XRes", UintegerValue (xRes));
+  remHelper->SetAttribute ("YRes", UintegerValue (yRes));
+  if (remRbId >= 0)
+    {
+      remHelper->SetAttribute ("UseDataChannel", BooleanValue (true));
+      remHelper->SetAttribute ("RbId", IntegerValue (remRbId));
+    }
+}
+
+/**
+ * Generate the REM of the scenario built so far with several worker
+ * processes.  The res + 1 grid columns are split into tiles of whole
+ * columns; every worker inherits the scenario, runs an ordinary
+ * RadioEnvironmentMapHelper over its tile, and the tile files are then
+ * concatenated in column order, which is the order the serial helper
+ * writes the points in.
+ *
+ * Only the control channel REM is identical to the serial one.  The data
+ * channel REM (remRbId >= 0) measures the signals sent at the simulated
+ * time of each point, which differs between a tile and the serial run,
+ * so main () generates it serially.
+ */
+void
+GenerateParallelRem (Box box, uint16_t res, int32_t remRbId, std::string outputFile, uint32_t jobs)
+{
+  SimProcessPool pool (jobs);
+  uint32_t nColumns = res + 1;
+  // a few tiles per worker balances the load; each tile needs two columns
+  uint32_t nTiles = std::min (pool.GetMaxWorkers () * 4, nColumns / 2);
+  double step = (box.xMax - box.xMin) / res;
+
+  std::vector<std::string> tileFiles;
+  for (uint32_t t = 0; t < nTiles; ++t)
+    {
+      uint32_t first = t * nColumns / nTiles;
+      uint32_t last = (t + 1) * nColumns / nTiles - 1;
+      std::ostringstream tileFile;
+      tileFile << outputFile << ".tile" << t << "." << getpid () << ".tmp";
+      tileFiles.push_back (tileFile.str ());
+
+      double xMin = box.xMin + first * step;
+      double xMax = box.xMin + last * step;
+      uint16_t xRes = last - first;
+      std::string file = tileFile.str ();
+      pool.Submit ([=] (std::ostream &)
+        {
+          Ptr<RadioEnvironmentMapHelper> remHelper = CreateObject<RadioEnvironmentMapHelper> ();
+          ConfigureRemHelper (remHelper, file, xMin, xMax, xRes, box, res, remRbId);
+          remHelper->Install ();
+          // simulation will stop right after the REM tile has been generated
+          Simulator::Run ();
+          Simulator::Destroy ();
+        });
+    }
+
+  NS_LOG_INFO ("Generating REM in " << nTiles << " tiles on " << pool.GetMaxWorkers () << " workers");
+  std::vector<SimProcessPool::JobResult> results = pool.Run ();
+
+  std::ofstream outFile (outputFile.c_str (), std::ios_base::out | std::ios_base::trunc);
+  if (!outFile.is_open ())
+    {
+      NS_FATAL_ERROR ("Can't open file " << outputFile);
+    }
+  for (uint32_t t = 0; t < nTiles; ++t)
+    {
+      if (!results[t].Ok ())
+        {
+          NS_FATAL_ERROR ("REM tile " << t << " failed with status " << results[t].status);
+        }
+      std::ifstream tile (tileFiles[t].c_str ());
+      outFile << tile.rdbuf ();
+      tile.close ();
+      std::remove (tileFiles[t].c_str ());
+    }
+}
+
+/// Parse "x,y;x,y;..." into positions at ground level, dropping malformed items
+std::vector<Vector>
+ParsePositions (const std::string &list)
+{
+  std::vector<Vector> positions;
+  std::istringstream items (list);
+  std::string item;
+  while (std::getline (items, item, ';'))
+    {
+      double x, y;
+      if (std::sscanf (item.c_str (), "%lf,%lf", &x, &y) == 2)
+        {
+          positions.push_back (Vector (x, y, 0.0));
+        }
+    }
+  return positions;
+}
+
 int main (int argc, char *argv[])
 {
   Config::SetDefault ("ns3::LteSpectrumPhy::CtrlErrorModelEnabled", BooleanValue (true));
@@ -91,8 +213,22 @@ int main (int argc, char *argv[])
   uint16_t numberOfRandomUes = 3;
   double simTime = 2.500;
   bool generateSpectrumTrace = true;
+  uint32_t spectrumPeriod = 10;
+  bool spectrumAverage = true;
+  bool spectrumBinary = false;
+  std::string spectrumAnalyzers = "";
   bool generateRem = true;
   int32_t remRbId = -1;
+  bool binaryTraces = false;
+  bool compressTraces = false;
+  uint16_t remResolution = 500;
+  uint32_t remJobs = 1;
+  bool remCube = false;
+  bool remCubeFfrMask = true;
+  std::string remCacheDir = "";
+  double remMaxDistance = 0;
+  uint32_t validateFastErrorModel = 0;
+  std::string fastErrorModelTable = "";
   uint16_t bandwidth = 25;
   double distance = 1000;
   Box macroUeBox = Box (-distance * 0.5, distance * 1.5, -distance * 0.5, distance * 1.5, 1.5, 1.5);
@@ -102,12 +238,51 @@ int main (int argc, char *argv[])
   cmd.AddValue ("numberOfUes", "Number of random UEs", numberOfRandomUes);
   cmd.AddValue ("simTime", "Total duration of the simulation (in seconds)", simTime);
   cmd.AddValue ("generateSpectrumTrace", "if true, will generate a Spectrum Analyzer trace", generateSpectrumTrace);
+  cmd.AddValue ("spectrumPeriod", "Time between two spectrum analyzer reports [us], "
+                "500 for one per slot, 1000 for one per subframe", spectrumPeriod);
+  cmd.AddValue ("spectrumAverage", "if true, every spectrum analyzer report is the average PSD over "
+                "spectrumPeriod, otherwise a 10 us sample taken every spectrumPeriod", spectrumAverage);
+  cmd.AddValue ("spectrumBinary", "if true, all spectrum analyzers write to the binary table "
+                "SpectrumAnalyzer.bin instead of one text file each", spectrumBinary);
+  cmd.AddValue ("spectrumAnalyzers", "Spectrum analyzer positions as x,y;x,y;... [m], "
+                "default: one analyzer at eNB3", spectrumAnalyzers);
   cmd.AddValue ("generateRem", "if true, will generate a REM and then abort the simulation", generateRem);
   cmd.AddValue ("remRbId", "Resource Block Id, for which REM will be generated,"
                 "default value is -1, what means REM will be averaged from all RBs", remRbId);
+  cmd.AddValue ("remResolution", "Number of REM grid steps along each axis", remResolution);
+  cmd.AddValue ("remJobs", "Number of worker processes generating the REM, "
+                "1 generates it serially, 0 uses one per CPU; the data channel REM "
+                "of remRbId is always generated serially", remJobs);
+  cmd.AddValue ("remCube", "if true, the REM is a binary cube with the SINR of every RB "
+                "(lena-frequency-reuse.remcube) instead of the REM helper output", remCube);
+  cmd.AddValue ("remCubeFfrMask", "if true, only the RBGs the FFR algorithm makes available "
+                "carry power in the REM cube", remCubeFfrMask);
+  cmd.AddValue ("remCacheDir", "if set, the REM is computed from per-eNB gain layers cached in this "
+                "directory; only layers of eNBs whose inputs changed are recomputed", remCacheDir);
+  cmd.AddValue ("remMaxDistance", "if positive, eNBs farther than this from a point are left out "
+                "of its SINR in the REM cube [m]", remMaxDistance);
+  cmd.AddValue ("validateFastErrorModel", "if positive, compare the error model lookup tables with the "
+                "MI error model on this many random allocations and exit; the simulation itself "
+                "always uses the MI error model", validateFastErrorModel);
+  cmd.AddValue ("fastErrorModelTable", "file caching the tables of the fast error model", fastErrorModelTable);
   cmd.AddValue ("runId", "runId", runId);
+  cmd.AddValue ("binaryTraces", "if true, write the LTE traces in binary columnar format", binaryTraces);
+  cmd.AddValue ("compressTraces", "Compress the binary traces with zstd", compressTraces);
   cmd.Parse (argc, argv);
 
+  if (validateFastErrorModel > 0)
+    {
+      LteFastErrorModel fastErrorModel (bandwidth, fastErrorModelTable);
+      fastErrorModel.Validate (std::cout, validateFastErrorModel, runId);
+      return 0;
+    }
+
+  if (generateRem && remJobs != 1 && remRbId < 0)
+    {
+      // every worker would append to the same spectrum analyzer trace
+      generateSpectrumTrace = false;
+    }
+
   RngSeedManager::SetSeed (1);
   RngSeedManager::SetRun (runId);
 
@@ -232,7 +407,8 @@ int main (int argc, char *argv[])
     }
 
   // Attach UE to a eNB
-  lteHelper->AttachToClosestEnb (randomUeDevs, enbDevs);
+  EnbSpatialIndex enbIndex (enbDevs);
+  enbIndex.AttachToClosestEnb (lteHelper, randomUeDevs);
 
   // Activate a data radio bearer
   enum EpsBearer::Qci q = EpsBearer::GBR_CONV_VOICE;
@@ -243,8 +419,8 @@ int main (int argc, char *argv[])
 
   //Spectrum analyzer
   NodeContainer spectrumAnalyzerNodes;
-  spectrumAnalyzerNodes.Create (1);
   SpectrumAnalyzerHelper spectrumAnalyzerHelper;
+  Ptr<SpectrumAnalyzerTrace> spectrumTrace;
 
   if (generateSpectrumTrace)
     {
@@ -252,7 +428,16 @@ int main (int argc, char *argv[])
       //position of Spectrum Analyzer
 //	  positionAlloc->Add (Vector (0.0, 0.0, 0.0));                              // eNB1
 //	  positionAlloc->Add (Vector (distance,  0.0, 0.0));                        // eNB2
-      positionAlloc->Add (Vector (distance * 0.5, distance * 0.866, 0.0));          // eNB3
+      std::vector<Vector> analyzerPositions = ParsePositions (spectrumAnalyzers);
+      if (analyzerPositions.empty ())
+        {
+          analyzerPositions.push_back (Vector (distance * 0.5, distance * 0.866, 0.0));          // eNB3
+        }
+      for (size_t i = 0; i < analyzerPositions.size (); ++i)
+        {
+          positionAlloc->Add (analyzerPositions[i]);
+        }
+      spectrumAnalyzerNodes.Create (analyzerPositions.size ());
 
       MobilityHelper mobility;
       mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
@@ -265,10 +450,23 @@ int main (int argc, char *argv[])
       spectrumAnalyzerHelper.SetChannel (dlChannel);
       Ptr<SpectrumModel> sm = LteSpectrumValueHelper::GetSpectrumModel (100, bandwidth);
       spectrumAnalyzerHelper.SetRxSpectrumModel (sm);
-      spectrumAnalyzerHelper.SetPhyAttribute ("Resolution", TimeValue (MicroSeconds (10)));
+      // the analyzer averages over its resolution, so averaging needs no post-processing
+      Time resolution = MicroSeconds (spectrumAverage ? spectrumPeriod : 10);
+      spectrumAnalyzerHelper.SetPhyAttribute ("Resolution", TimeValue (resolution));
       spectrumAnalyzerHelper.SetPhyAttribute ("NoisePowerSpectralDensity", DoubleValue (1e-15));     // -120 dBm/Hz
-      spectrumAnalyzerHelper.EnableAsciiAll ("spectrum-analyzer-output");
-      spectrumAnalyzerHelper.Install (spectrumAnalyzerNodes);
+      if (spectrumBinary || !spectrumAverage)
+        {
+          Time samplePeriod = spectrumAverage ? Time (0) : MicroSeconds (spectrumPeriod);
+          std::string filename = spectrumBinary ? std::string ("SpectrumAnalyzer.bin") + (compressTraces ? ".zst" : "")
+                                                : std::string ("spectrum-analyzer-output");
+          spectrumTrace = Create<SpectrumAnalyzerTrace> (filename, sm, samplePeriod, spectrumBinary);
+          spectrumTrace->Install (spectrumAnalyzerHelper.Install (spectrumAnalyzerNodes));
+        }
+      else
+        {
+          spectrumAnalyzerHelper.EnableAsciiAll ("spectrum-analyzer-output");
+          spectrumAnalyzerHelper.Install (spectrumAnalyzerNodes);
+        }
     }
 
   Ptr<RadioEnvironmentMapHelper> remHelper;
@@ -276,22 +474,39 @@ int main (int argc, char *argv[])
     {
       PrintGnuplottableNodeListToFile ("SINR_graph.p");
 
-      remHelper = CreateObject<RadioEnvironmentMapHelper> ();
-      remHelper->SetAttribute ("ChannelPath", StringValue ("/ChannelList/0"));
-      remHelper->SetAttribute ("OutputFile", StringValue ("lena-frequency-reuse.rem"));
-      remHelper->SetAttribute ("XMin", DoubleValue (macroUeBox.xMin));
-      remHelper->SetAttribute ("XMax", DoubleValue (macroUeBox.xMax));
-      remHelper->SetAttribute ("YMin", DoubleValue (macroUeBox.yMin));
-      remHelper->SetAttribute ("YMax", DoubleValue (macroUeBox.yMax));
-      remHelper->SetAttribute ("Z", DoubleValue (1.5));
-      remHelper->SetAttribute ("XRes", UintegerValue (500));
-      remHelper->SetAttribute ("YRes", UintegerValue (500));
-      if (remRbId >= 0)
+      if (remCube || !remCacheDir.empty () || remMaxDistance > 0)
+        {
+          // the averaged REM measures the control channel, which spans all RBs
+          LteRemCube cube (macroUeBox, remResolution);
+          cube.AddEnbs (enbDevs, remCubeFfrMask && (remCube || remRbId >= 0));
+          cube.SetCacheDirectory (remCacheDir);
+          cube.SetMaxDistance (remMaxDistance);
+          uint32_t computed = cube.LoadLayers (remJobs);
+          NS_LOG_INFO ("Computed " << computed << " of " << enbDevs.GetN () << " REM gain layers");
+          if (remCube)
+            {
+              cube.Generate ("lena-frequency-reuse.remcube", remJobs);
+            }
+          else
+            {
+              // default NoisePower of RadioEnvironmentMapHelper
+              cube.WriteRem ("lena-frequency-reuse.rem", remRbId, 1.4230e-13, remJobs);
+            }
+          Simulator::Destroy ();
+          return 0;
+        }
+
+      if (remJobs != 1 && remRbId < 0)
         {
-          remHelper->SetAttribute ("UseDataChannel", BooleanValue (true));
-          remHelper->SetAttribute ("RbId", IntegerValue (remRbId));
+          GenerateParallelRem (macroUeBox, remResolution, remRbId, "lena-frequency-reuse.rem", remJobs);
+          Simulator::Destroy ();
+          return 0;
         }
 
+      remHelper = CreateObject<RadioEnvironmentMapHelper> ();
+      ConfigureRemHelper (remHelper, "lena-frequency-reuse.rem", macroUeBox.xMin, macroUeBox.xMax,
+                          remResolution, macroUeBox, remResolution, remRbId);
+
       remHelper->Install ();
       // simulation will stop right after the REM has been generated
 
@@ -303,16 +518,36 @@ int main (int argc, char *argv[])
       Simulator::Stop (Seconds (simTime));
     }
 
-  lteHelper->EnablePhyTraces ();
-  lteHelper->EnableMacTraces ();
-  lteHelper->EnableRlcTraces ();
-  lteHelper->EnablePdcpTraces ();
-  Ptr<RadioBearerStatsCalculator> rlcStats = lteHelper->GetRlcStats ();
-  rlcStats->SetAttribute ("StartTime", TimeValue (Seconds (0)));
-  rlcStats->SetAttribute ("EpochDuration", TimeValue (Seconds (0.2)));
+  Ptr<LteBinaryTraceHelper> binaryTraceHelper;
+  if (binaryTraces)
+    {
+      NetDeviceContainer ueDevs (edgeUeDevs, centerUeDevs);
+      ueDevs.Add (randomUeDevs);
+      binaryTraceHelper = Create<LteBinaryTraceHelper> ("", compressTraces);
+      binaryTraceHelper->Install (enbDevs, ueDevs);
+    }
+  else
+    {
+      lteHelper->EnablePhyTraces ();
+      lteHelper->EnableMacTraces ();
+      lteHelper->EnableRlcTraces ();
+      lteHelper->EnablePdcpTraces ();
+      Ptr<RadioBearerStatsCalculator> rlcStats = lteHelper->GetRlcStats ();
+      rlcStats->SetAttribute ("StartTime", TimeValue (Seconds (0)));
+      rlcStats->SetAttribute ("EpochDuration", TimeValue (Seconds (0.2)));
+    }
 
   Simulator::Run ();
 
+  if (binaryTraceHelper)
+    {
+      binaryTraceHelper->Close ();
+    }
+  if (spectrumTrace)
+    {
+      spectrumTrace->Close ();
+    }
+
 
 
     
@@ -28,6 +28,10 @@
 #include "ns3/lte-module.h"
 //#include "ns3/gtk-config-store.h"
 
+#include "enb-spatial-index.h"
+#include "lte-binary-traces.h"
+#include "steady-state-goodput.h"
+
 using namespace ns3;
 
 /**
@@ -53,6 +57,11 @@ main (int argc, char *argv[])
   bool edge = true;
   bool random = false;
   std::string algo = "NoOp";
+  bool binaryTraces = false;
+  bool compressTraces = false;
+  uint32_t x2Neighbours = 0;
+  bool warmupDetection = false;
+  Time warmupWindow = MilliSeconds (50);
  /* Box leftBound = Box (-distance * 0.5, distance * 0.5, -distance * 0.5, distance * 0.5, 1.5, 1.5);
   Box rightBound = Box (distance * 0.5, distance * 1.5, -distance * 0.5, distance * 0.5, 1.5, 1.5);
   Box topBound = Box (distance * 0.28867, distance * 0.866, -distance * 1.5, -distance * 0.5, 1.5, 1.5);
@@ -72,6 +81,13 @@ main (int argc, char *argv[])
    cmd.AddValue ("edge", "Edge nodes?", edge);
    cmd.AddValue ("algo", "Algo", algo);
    cmd.AddValue ("random", "Random?", random);
+  cmd.AddValue ("binaryTraces", "Write the LTE traces in binary columnar format", binaryTraces);
+  cmd.AddValue ("compressTraces", "Compress the binary traces with zstd", compressTraces);
+  cmd.AddValue ("x2Neighbours", "If positive, connect each eNB over X2 to this many closest eNBs "
+                "instead of to all of them", x2Neighbours);
+  cmd.AddValue ("warmupDetection", "Detect the warm-up of every flow with MSER-5 and measure "
+                "its goodput from there instead of from 0.5 s", warmupDetection);
+  cmd.AddValue ("warmupWindow", "Window of the throughput series of the warm-up detection", warmupWindow);
 
   cmd.Parse (argc, argv);
 
@@ -340,7 +356,15 @@ main (int argc, char *argv[])
   }
 
   
-  lteHelper->AddX2Interface (enbNodes);
+  if (x2Neighbours > 0)
+    {
+      EnbSpatialIndex enbIndex (enbLteDevs);
+      enbIndex.AddX2Interfaces (lteHelper, x2Neighbours);
+    }
+  else
+    {
+      lteHelper->AddX2Interface (enbNodes);
+    }
 
       // Activate a data radio bearer
   //enum EpsBearer::Qci q = EpsBearer::GBR_CONV_VOICE;
@@ -396,10 +420,30 @@ main (int argc, char *argv[])
   clientApps.Start (MilliSeconds (500));
 
   
-  lteHelper->EnableTraces ();
+  Ptr<LteBinaryTraceHelper> binaryTraceHelper;
+  if (binaryTraces)
+    {
+      binaryTraceHelper = Create<LteBinaryTraceHelper> ("", compressTraces);
+      binaryTraceHelper->Install (enbLteDevs, ueLteDevs);
+    }
+  else
+    {
+      lteHelper->EnableTraces ();
+    }
   // Uncomment to enable PCAP tracing
   //p2ph.EnablePcapAll("lena-simple-epc");
 
+  Ptr<SteadyStateGoodput> steadyState;
+  if (warmupDetection)
+    {
+      steadyState = Create<SteadyStateGoodput> (warmupWindow, MilliSeconds (500));
+      for (uint32_t i = 0; i < serverApps.GetN (); ++i)
+        {
+          steadyState->AddFlow (serverApps.Get (i));
+        }
+      steadyState->Start (simTime);
+    }
+
   Simulator::Stop (simTime);
   Simulator::Run ();
 
@@ -418,7 +462,17 @@ for (uint16_t i = 0; i < pairs; i++)
     Ptr<PacketSink> sink = DynamicCast<PacketSink>(serverApps.Get(i));
 
     
-    std::cout << "Node: " << i << ": Total Bytes Received: " <<  sink->GetTotalRx() << " Goodput: " << (sink->GetTotalRx()*8)/0.5 << std::endl; 
+    double goodput = sink->GetTotalRx () * 8 / (simTime - MilliSeconds (500)).GetSeconds ();
+    if (steadyState)
+      {
+        goodput = steadyState->GetGoodput (i);
+      }
+    std::cout << "Node: " << i << ": Total Bytes Received: " <<  sink->GetTotalRx() << " Goodput: " << goodput;
+    if (steadyState)
+      {
+        std::cout << " (steady state from " << steadyState->GetWarmupEnd (i).GetSeconds () << " s)";
+      }
+    std::cout << std::endl;
   }
   Simulator::Destroy ();
   return 0;
@@ -0,0 +1,347 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef LTE_BINARY_TRACES_H
+#define LTE_BINARY_TRACES_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/lte-module.h>
+#include <ns3/spectrum-value.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binary-trace-format.h"
+
+namespace ns3 {
+
+/**
+ * Binary replacement for LteHelper::EnableTraces ().
+ *
+ * Connects to the trace sources behind the PHY, MAC, RLC and PDCP stats
+ * calculators and stores every sample as one row of a columnar binary
+ * table (see binary-trace-format.h), one file per table:
+ *
+ *   <prefix>DlRsrpSinr.bin, <prefix>UlSinr.bin, <prefix>UlInterference.bin,
+ *   <prefix>DlMac.bin, <prefix>UlMac.bin,
+ *   <prefix>DlRlc.bin, <prefix>UlRlc.bin, <prefix>DlPdcp.bin, <prefix>UlPdcp.bin
+ *
+ * With compress set, every file is a zstd stream with ".zst" appended to
+ * its name; lte-trace-convert reads both.  Times are stored in
+ * nanoseconds.  RLC and PDCP tables hold the raw PDU events instead of
+ * per-epoch aggregates, so that the epoch can be chosen when converting
+ * back to text with lte-trace-convert.
+ */
+class LteBinaryTraceHelper : public SimpleRefCount<LteBinaryTraceHelper>
+{
+public:
+  explicit LteBinaryTraceHelper (const std::string &prefix = "", bool compress = false)
+  {
+    std::string ext = compress ? ".zst" : "";
+    typedef BinaryTraceColumn C;
+    std::vector<C> c;
+
+    c.push_back (C ("time", C::U64));
+    c.push_back (C ("cellId", C::U16));
+    c.push_back (C ("imsi", C::U64));
+    c.push_back (C ("rnti", C::U16));
+    c.push_back (C ("rsrp", C::F64));
+    c.push_back (C ("sinr", C::F64));
+    c.push_back (C ("componentCarrierId", C::U8));
+    m_dlRsrpSinr.reset (new BinaryTraceWriter (prefix + "DlRsrpSinr.bin" + ext, "DlRsrpSinr", c));
+
+    c.clear ();
+    c.push_back (C ("time", C::U64));
+    c.push_back (C ("cellId", C::U16));
+    c.push_back (C ("imsi", C::U64));
+    c.push_back (C ("rnti", C::U16));
+    c.push_back (C ("sinrLinear", C::F64));
+    c.push_back (C ("componentCarrierId", C::U8));
+    m_ulSinr.reset (new BinaryTraceWriter (prefix + "UlSinr.bin" + ext, "UlSinr", c));
+
+    c.clear ();
+    c.push_back (C ("time", C::U64));
+    c.push_back (C ("cellId", C::U16));
+    c.push_back (C ("rb", C::U16));
+    c.push_back (C ("interference", C::F64));
+    m_ulInterference.reset (new BinaryTraceWriter (prefix + "UlInterference.bin" + ext, "UlInterference", c));
+
+    c.clear ();
+    c.push_back (C ("time", C::U64));
+    c.push_back (C ("cellId", C::U16));
+    c.push_back (C ("imsi", C::U64));
+    c.push_back (C ("frame", C::U32));
+    c.push_back (C ("sframe", C::U32));
+    c.push_back (C ("rnti", C::U16));
+    c.push_back (C ("mcsTb1", C::U8));
+    c.push_back (C ("sizeTb1", C::U16));
+    c.push_back (C ("mcsTb2", C::U8));
+    c.push_back (C ("sizeTb2", C::U16));
+    c.push_back (C ("componentCarrierId", C::U8));
+    m_dlMac.reset (new BinaryTraceWriter (prefix + "DlMac.bin" + ext, "DlMac", c));
+
+    c.clear ();
+    c.push_back (C ("time", C::U64));
+    c.push_back (C ("cellId", C::U16));
+    c.push_back (C ("imsi", C::U64));
+    c.push_back (C ("frame", C::U32));
+    c.push_back (C ("sframe", C::U32));
+    c.push_back (C ("rnti", C::U16));
+    c.push_back (C ("mcs", C::U8));
+    c.push_back (C ("size", C::U16));
+    c.push_back (C ("componentCarrierId", C::U8));
+    m_ulMac.reset (new BinaryTraceWriter (prefix + "UlMac.bin" + ext, "UlMac", c));
+
+    // event is 0 for a transmitted PDU and 1 for a received one
+    c.clear ();
+    c.push_back (C ("time", C::U64));
+    c.push_back (C ("cellId", C::U16));
+    c.push_back (C ("imsi", C::U64));
+    c.push_back (C ("rnti", C::U16));
+    c.push_back (C ("lcid", C::U8));
+    c.push_back (C ("event", C::U8));
+    c.push_back (C ("size", C::U32));
+    c.push_back (C ("delay", C::U64));
+    m_dlRlc.reset (new BinaryTraceWriter (prefix + "DlRlc.bin" + ext, "DlRlc", c));
+    m_ulRlc.reset (new BinaryTraceWriter (prefix + "UlRlc.bin" + ext, "UlRlc", c));
+    m_dlPdcp.reset (new BinaryTraceWriter (prefix + "DlPdcp.bin" + ext, "DlPdcp", c));
+    m_ulPdcp.reset (new BinaryTraceWriter (prefix + "UlPdcp.bin" + ext, "UlPdcp", c));
+  }
+
+  /// Connect to the traces of the given eNB and UE devices
+  void Install (NetDeviceContainer enbDevs, NetDeviceContainer ueDevs)
+  {
+    for (uint32_t i = 0; i < ueDevs.GetN (); ++i)
+      {
+        Ptr<LteUeNetDevice> ueDev = ueDevs.Get (i)->GetObject<LteUeNetDevice> ();
+        NS_ASSERT (ueDev);
+        ueDev->GetPhy ()->TraceConnectWithoutContext ("ReportCurrentCellRsrpSinr",
+                                                      MakeBoundCallback (&LteBinaryTraceHelper::DlRsrpSinr, this, ueDev->GetImsi ()));
+        ueDev->GetRrc ()->TraceConnectWithoutContext ("ConnectionReconfiguration",
+                                                      MakeBoundCallback (&LteBinaryTraceHelper::UeReconfigured, this, GetDevicePath (ueDev)));
+      }
+    for (uint32_t i = 0; i < enbDevs.GetN (); ++i)
+      {
+        Ptr<LteEnbNetDevice> enbDev = enbDevs.Get (i)->GetObject<LteEnbNetDevice> ();
+        NS_ASSERT (enbDev);
+        uint16_t cellId = enbDev->GetCellId ();
+        enbDev->GetPhy ()->TraceConnectWithoutContext ("ReportUeSinr",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::UlSinr, this));
+        enbDev->GetPhy ()->TraceConnectWithoutContext ("ReportInterference",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::UlInterference, this));
+        enbDev->GetMac ()->TraceConnectWithoutContext ("DlScheduling",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::DlScheduling, this, cellId));
+        enbDev->GetMac ()->TraceConnectWithoutContext ("UlScheduling",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::UlScheduling, this, cellId));
+        enbDev->GetRrc ()->TraceConnectWithoutContext ("ConnectionEstablished",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::UeAssociated, this));
+        enbDev->GetRrc ()->TraceConnectWithoutContext ("HandoverEndOk",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::UeAssociated, this));
+        enbDev->GetRrc ()->TraceConnectWithoutContext ("ConnectionReconfiguration",
+                                                       MakeBoundCallback (&LteBinaryTraceHelper::EnbReconfigured, this, GetDevicePath (enbDev)));
+      }
+  }
+
+  /// Flush and close every table; called automatically on destruction
+  void Close ()
+  {
+    m_dlRsrpSinr->Close ();
+    m_ulSinr->Close ();
+    m_ulInterference->Close ();
+    m_dlMac->Close ();
+    m_ulMac->Close ();
+    m_dlRlc->Close ();
+    m_ulRlc->Close ();
+    m_dlPdcp->Close ();
+    m_ulPdcp->Close ();
+  }
+
+private:
+  typedef std::pair<uint16_t, uint16_t> CellIdRnti;
+
+  static std::string GetDevicePath (Ptr<NetDevice> dev)
+  {
+    Ptr<Node> node = dev->GetNode ();
+    for (uint32_t d = 0; d < node->GetNDevices (); ++d)
+      {
+        if (node->GetDevice (d) == dev)
+          {
+            std::ostringstream path;
+            path << "/NodeList/" << node->GetId () << "/DeviceList/" << d;
+            return path.str ();
+          }
+      }
+    NS_FATAL_ERROR ("device not found on its own node");
+    return "";
+  }
+
+  uint64_t FindImsi (uint16_t cellId, uint16_t rnti) const
+  {
+    std::map<CellIdRnti, uint64_t>::const_iterator it = m_imsiByRnti.find (CellIdRnti (cellId, rnti));
+    return it == m_imsiByRnti.end () ? 0 : it->second;
+  }
+
+  static uint64_t Now ()
+  {
+    return Simulator::Now ().GetNanoSeconds ();
+  }
+
+  static void DlRsrpSinr (LteBinaryTraceHelper *h, uint64_t imsi,
+                          uint16_t cellId, uint16_t rnti, double rsrp, double sinr, uint8_t componentCarrierId)
+  {
+    h->m_dlRsrpSinr->Add (Now ()).Add (cellId).Add (imsi).Add (rnti).Add (rsrp).Add (sinr).Add (componentCarrierId);
+    h->m_dlRsrpSinr->EndRow ();
+  }
+
+  static void UlSinr (LteBinaryTraceHelper *h,
+                      uint16_t cellId, uint16_t rnti, double sinrLinear, uint8_t componentCarrierId)
+  {
+    h->m_ulSinr->Add (Now ()).Add (cellId).Add (h->FindImsi (cellId, rnti)).Add (rnti).Add (sinrLinear).Add (componentCarrierId);
+    h->m_ulSinr->EndRow ();
+  }
+
+  static void UlInterference (LteBinaryTraceHelper *h, uint16_t cellId, Ptr<SpectrumValue> interference)
+  {
+    uint64_t now = Now ();
+    for (size_t rb = 0; rb < interference->GetValuesN (); ++rb)
+      {
+        h->m_ulInterference->Add (now).Add (cellId).Add (rb).Add ((*interference)[rb]);
+        h->m_ulInterference->EndRow ();
+      }
+  }
+
+  static void DlScheduling (LteBinaryTraceHelper *h, uint16_t cellId, DlSchedulingCallbackInfo info)
+  {
+    h->m_dlMac->Add (Now ()).Add (cellId).Add (h->FindImsi (cellId, info.rnti))
+      .Add (info.frameNo).Add (info.subframeNo).Add (info.rnti)
+      .Add (info.mcsTb1).Add (info.sizeTb1).Add (info.mcsTb2).Add (info.sizeTb2)
+      .Add (info.componentCarrierId);
+    h->m_dlMac->EndRow ();
+  }
+
+  static void UlScheduling (LteBinaryTraceHelper *h, uint16_t cellId,
+                            uint32_t frameNo, uint32_t subframeNo, uint16_t rnti,
+                            uint8_t mcs, uint16_t size, uint8_t componentCarrierId)
+  {
+    h->m_ulMac->Add (Now ()).Add (cellId).Add (h->FindImsi (cellId, rnti))
+      .Add (frameNo).Add (subframeNo).Add (rnti).Add (mcs).Add (size).Add (componentCarrierId);
+    h->m_ulMac->EndRow ();
+  }
+
+  static void UeAssociated (LteBinaryTraceHelper *h, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+  {
+    h->m_imsiByRnti[CellIdRnti (cellId, rnti)] = imsi;
+  }
+
+  /// Write one RLC or PDCP PDU event of the UE (imsi, cellId)
+  struct PduContext
+  {
+    BinaryTraceWriter *writer;
+    uint64_t imsi;
+    uint16_t cellId;
+  };
+
+  static void TxPdu (PduContext *c, uint16_t rnti, uint8_t lcid, uint32_t size)
+  {
+    c->writer->Add (Now ()).Add (c->cellId).Add (c->imsi).Add (rnti).Add (lcid).Add (0).Add (size).Add (0);
+    c->writer->EndRow ();
+  }
+
+  static void RxPdu (PduContext *c, uint16_t rnti, uint8_t lcid, uint32_t size, uint64_t delay)
+  {
+    c->writer->Add (Now ()).Add (c->cellId).Add (c->imsi).Add (rnti).Add (lcid).Add (1).Add (size).Add (delay);
+    c->writer->EndRow ();
+  }
+
+  /**
+   * Connect the PDU traces of every bearer below base.  The bearers only
+   * exist once the RRC connection has been (re)configured, which is why
+   * this is done from the ConnectionReconfiguration traces.
+   */
+  void ConnectBearers (const std::string &base, uint64_t imsi, uint16_t cellId,
+                       BinaryTraceWriter *txRlc, BinaryTraceWriter *rxRlc,
+                       BinaryTraceWriter *txPdcp, BinaryTraceWriter *rxPdcp)
+  {
+    std::ostringstream key;
+    key << base << "#" << cellId;
+    if (!m_connected.insert (key.str ()).second)
+      {
+        return;
+      }
+    const char *bearers[] = {"/Srb1", "/DataRadioBearerMap/*"};
+    for (int b = 0; b < 2; ++b)
+      {
+        std::string path = base + bearers[b];
+        Config::ConnectWithoutContext (path + "/LteRlc/TxPDU",
+                                       MakeBoundCallback (&LteBinaryTraceHelper::TxPdu, NewContext (txRlc, imsi, cellId)));
+        Config::ConnectWithoutContext (path + "/LteRlc/RxPDU",
+                                       MakeBoundCallback (&LteBinaryTraceHelper::RxPdu, NewContext (rxRlc, imsi, cellId)));
+        Config::ConnectWithoutContext (path + "/LtePdcp/TxPDU",
+                                       MakeBoundCallback (&LteBinaryTraceHelper::TxPdu, NewContext (txPdcp, imsi, cellId)));
+        Config::ConnectWithoutContext (path + "/LtePdcp/RxPDU",
+                                       MakeBoundCallback (&LteBinaryTraceHelper::RxPdu, NewContext (rxPdcp, imsi, cellId)));
+      }
+  }
+
+  PduContext *NewContext (BinaryTraceWriter *writer, uint64_t imsi, uint16_t cellId)
+  {
+    PduContext c = {writer, imsi, cellId};
+    m_contexts.push_back (std::unique_ptr<PduContext> (new PduContext (c)));
+    return m_contexts.back ().get ();
+  }
+
+  static void UeReconfigured (LteBinaryTraceHelper *h, std::string devicePath,
+                              uint64_t imsi, uint16_t cellId, uint16_t rnti)
+  {
+    // the UE transmits uplink PDUs and receives downlink ones
+    h->ConnectBearers (devicePath + "/LteUeRrc", imsi, cellId,
+                       h->m_ulRlc.get (), h->m_dlRlc.get (), h->m_ulPdcp.get (), h->m_dlPdcp.get ());
+  }
+
+  static void EnbReconfigured (LteBinaryTraceHelper *h, std::string devicePath,
+                               uint64_t imsi, uint16_t cellId, uint16_t rnti)
+  {
+    std::ostringstream base;
+    base << devicePath << "/LteEnbRrc/UeMap/" << rnti;
+    h->ConnectBearers (base.str (), imsi, cellId,
+                       h->m_dlRlc.get (), h->m_ulRlc.get (), h->m_dlPdcp.get (), h->m_ulPdcp.get ());
+  }
+
+  std::unique_ptr<BinaryTraceWriter> m_dlRsrpSinr;
+  std::unique_ptr<BinaryTraceWriter> m_ulSinr;
+  std::unique_ptr<BinaryTraceWriter> m_ulInterference;
+  std::unique_ptr<BinaryTraceWriter> m_dlMac;
+  std::unique_ptr<BinaryTraceWriter> m_ulMac;
+  std::unique_ptr<BinaryTraceWriter> m_dlRlc;
+  std::unique_ptr<BinaryTraceWriter> m_ulRlc;
+  std::unique_ptr<BinaryTraceWriter> m_dlPdcp;
+  std::unique_ptr<BinaryTraceWriter> m_ulPdcp;
+  std::map<CellIdRnti, uint64_t> m_imsiByRnti;
+  std::set<std::string> m_connected;
+  std::vector<std::unique_ptr<PduContext> > m_contexts;
+};
+
+} // namespace ns3
+
+#endif /* LTE_BINARY_TRACES_H */
@@ -0,0 +1,395 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef LTE_FAST_ERROR_MODEL_H
+#define LTE_FAST_ERROR_MODEL_H
+
+#include <ns3/core-module.h>
+#include <ns3/lte-module.h>
+#include <ns3/spectrum-module.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+/**
+ * Lookup tables of the data error model of LteMiErrorModel, and a
+ * harness that validates them against the full model.
+ *
+ * No simulation uses these tables: LteSpectrumPhy calls LteMiErrorModel
+ * directly, and it lives in the ns-3 LTE module, which these scripts
+ * cannot reconfigure.  A fast error model mode for runs needs a hook
+ * there; until then this only measures the accuracy and the speed-up a
+ * table lookup would give.
+ *
+ * The MI error model maps the SINR of every RB to a mutual information
+ * that depends on the modulation of the MCS, averages it into the MIB of
+ * the transport block, and maps the MIB to a BLER that depends on the MCS
+ * and the code block segmentation of the TB size.  Both mappings are
+ * tabulated here once, on a regular SINR grid in dB:
+ *
+ *  - mi[mcs][s]: the MI of one RB at SINR s;
+ *  - bler[mcs][nRb - 1][s]: the BLER of the TB of mcs over nRb RBs, of
+ *    the size LteAmc gives it, when every RB is at SINR s.
+ *
+ * A lookup averages the interpolated MI of the RBs, finds the uniform
+ * SINR that has the same MI, and interpolates the BLER there, which is
+ * what the full model computes up to the quantization of the grid.  Only
+ * first transmissions are covered: the HARQ combining of the full model
+ * needs the MI history of the process.
+ *
+ * With a file name given, the tables are memory-mapped from it, and
+ * computed and written there first if it does not hold tables of the
+ * same dimensions.  File layout (host byte order):
+ *
+ *   char[8]  magic "LTEFEML1"
+ *   uint32   nMcs, maxRb, nSinr
+ *   double   minDb, stepDb
+ *   float    mi[nMcs][nSinr]
+ *   float    bler[nMcs][maxRb][nSinr]
+ */
+class LteFastErrorModel : public SimpleRefCount<LteFastErrorModel>
+{
+public:
+  /**
+   * \param maxRb largest allocation the tables cover, usually the bandwidth
+   * \param file table file, or empty to keep the tables in memory only
+   * \param minDb lowest SINR of the grid [dB]
+   * \param maxDb highest SINR of the grid [dB]
+   * \param stepDb SINR step of the grid [dB]
+   */
+  LteFastErrorModel (uint16_t maxRb, const std::string &file = "",
+                     double minDb = -10.0, double maxDb = 30.0, double stepDb = 0.1)
+    : m_maxRb (maxRb),
+      m_nSinr (static_cast<uint32_t> (std::floor ((maxDb - minDb) / stepDb + 0.5)) + 1),
+      m_minDb (minDb),
+      m_stepDb (stepDb),
+      m_map (0),
+      m_mapSize (0)
+  {
+    NS_ABORT_MSG_IF (maxRb == 0 || stepDb <= 0 || maxDb <= minDb, "invalid table dimensions");
+    if (!file.empty () && Map (file))
+      {
+        return;
+      }
+    Compute ();
+    if (!file.empty ())
+      {
+        Write (file);
+        if (Map (file))
+          {
+            std::vector<float> ().swap (m_table);
+          }
+      }
+  }
+
+  ~LteFastErrorModel ()
+  {
+    if (m_map)
+      {
+        munmap (m_map, m_mapSize);
+      }
+  }
+
+  /**
+   * \param sinr linear SINR of each RB of the allocation
+   * \param nRb number of RBs of the allocation
+   * \param mcs MCS of the TB
+   * \return the BLER of the first transmission of the TB
+   */
+  double GetTbBler (const double *sinr, size_t nRb, uint8_t mcs) const
+  {
+    NS_ABORT_MSG_IF (nRb == 0 || nRb > m_maxRb, "allocation of " << nRb << " RBs outside the table");
+    NS_ABORT_MSG_IF (mcs >= N_MCS, "MCS " << (uint16_t) mcs << " outside the table");
+    const float *mi = m_mi + static_cast<size_t> (mcs) * m_nSinr;
+    double mib = 0;
+    for (size_t rb = 0; rb < nRb; ++rb)
+      {
+        mib += Interpolate (mi, 10 * std::log10 (sinr[rb]));
+      }
+    mib /= nRb;
+    const float *bler = m_bler + (static_cast<size_t> (mcs) * m_maxRb + nRb - 1) * m_nSinr;
+    return Interpolate (bler, GetUniformSinrDb (mi, mib));
+  }
+
+  /**
+   * Compare the tables with LteMiErrorModel on random synthetic
+   * allocations and write the BLER error, the expected bits delivered (TB
+   * size times the success probability, not a simulated goodput) of both
+   * models and their run time to os.
+   * \param samples number of random allocations
+   * \param seed seed of the allocations, independent of the ns-3 streams
+   */
+  void Validate (std::ostream &os, uint32_t samples, uint32_t seed) const
+  {
+    std::mt19937 rng (seed);
+    std::uniform_int_distribution<int> mcsDist (0, N_MCS - 1);
+    std::uniform_int_distribution<int> rbDist (1, m_maxRb);
+    std::uniform_real_distribution<double> meanDb (m_minDb + 5, m_minDb + (m_nSinr - 1) * m_stepDb - 5);
+    std::normal_distribution<double> fadingDb (0.0, 3.0);
+
+    Ptr<LteAmc> amc = CreateObject<LteAmc> ();
+    Ptr<SpectrumValue> sinr = Create<SpectrumValue> (LteSpectrumValueHelper::GetSpectrumModel (100, m_maxRb));
+    std::vector<uint8_t> mcs (samples);
+    std::vector<std::vector<int> > maps (samples);
+    std::vector<std::vector<double> > values (samples);
+    std::vector<uint16_t> sizes (samples);
+    for (uint32_t n = 0; n < samples; ++n)
+      {
+        mcs[n] = mcsDist (rng);
+        int nRb = rbDist (rng);
+        double mean = meanDb (rng);
+        for (int rb = 0; rb < nRb; ++rb)
+          {
+            maps[n].push_back (rb);
+            values[n].push_back (std::pow (10.0, (mean + fadingDb (rng)) / 10));
+          }
+        sizes[n] = amc->GetDlTbSizeFromMcs (mcs[n], nRb) / 8;
+      }
+
+    std::vector<double> full (samples);
+    SystemWallClockMs clock;
+    clock.Start ();
+    for (uint32_t n = 0; n < samples; ++n)
+      {
+        for (size_t i = 0; i < values[n].size (); ++i)
+          {
+            (*sinr)[i] = values[n][i];
+          }
+        full[n] = LteMiErrorModel::GetTbDecodificationStats (*sinr, maps[n], sizes[n], mcs[n],
+                                                             HarqProcessInfoList_t ()).tbler;
+      }
+    int64_t fullMs = clock.End ();
+
+    std::vector<double> fast (samples);
+    clock.Start ();
+    for (uint32_t n = 0; n < samples; ++n)
+      {
+        fast[n] = GetTbBler (&values[n][0], values[n].size (), mcs[n]);
+      }
+    int64_t fastMs = clock.End ();
+
+    double maxError = 0;
+    double sumError = 0;
+    double fullBits = 0;
+    double fastBits = 0;
+    for (uint32_t n = 0; n < samples; ++n)
+      {
+        double error = std::fabs (fast[n] - full[n]);
+        maxError = std::max (maxError, error);
+        sumError += error;
+        fullBits += sizes[n] * 8 * (1 - full[n]);
+        fastBits += sizes[n] * 8 * (1 - fast[n]);
+      }
+    os << "Fast error model over " << samples << " allocations of up to " << m_maxRb << " RBs:\n"
+       << "  BLER error: mean " << sumError / std::max<uint32_t> (samples, 1) << ", max " << maxError << "\n"
+       << "  expected TB bits delivered: full " << fullBits << ", fast " << fastBits << " ("
+       << 100 * (fastBits - fullBits) / std::max (fullBits, 1.0) << " %)\n"
+       << "  run time: full " << fullMs << " ms, fast " << fastMs << " ms\n";
+  }
+
+private:
+  /// MCS 0 to 28, as in the MI error model
+  static const uint32_t N_MCS = 29;
+
+  /// \return row interpolated at sinrDb, clamped to the grid
+  double Interpolate (const float *row, double sinrDb) const
+  {
+    double x = (sinrDb - m_minDb) / m_stepDb;
+    if (!(x > 0))
+      {
+        return row[0];
+      }
+    if (x >= m_nSinr - 1)
+      {
+        return row[m_nSinr - 1];
+      }
+    size_t i = static_cast<size_t> (x);
+    double f = x - i;
+    return row[i] + f * (row[i + 1] - row[i]);
+  }
+
+  /// \return the SINR at which the MI row, non decreasing, reaches mi [dB]
+  double GetUniformSinrDb (const float *row, double mi) const
+  {
+    const float *end = row + m_nSinr;
+    const float *it = std::lower_bound (row, end, static_cast<float> (mi));
+    if (it == row)
+      {
+        return m_minDb;
+      }
+    if (it == end)
+      {
+        return m_minDb + (m_nSinr - 1) * m_stepDb;
+      }
+    size_t i = it - row - 1;
+    double f = row[i + 1] > row[i] ? (mi - row[i]) / (row[i + 1] - row[i]) : 0.0;
+    return m_minDb + (i + f) * m_stepDb;
+  }
+
+  size_t GetTableSize () const
+  {
+    return static_cast<size_t> (N_MCS) * m_nSinr * (1 + m_maxRb);
+  }
+
+  void SetTables (const float *table)
+  {
+    m_mi = table;
+    m_bler = table + static_cast<size_t> (N_MCS) * m_nSinr;
+  }
+
+  void Compute ()
+  {
+    m_table.resize (GetTableSize ());
+    float *mi = &m_table[0];
+    float *bler = mi + static_cast<size_t> (N_MCS) * m_nSinr;
+    Ptr<LteAmc> amc = CreateObject<LteAmc> ();
+    Ptr<SpectrumValue> sinr = Create<SpectrumValue> (LteSpectrumValueHelper::GetSpectrumModel (100, m_maxRb));
+    std::vector<int> map;
+    for (uint16_t nRb = 1; nRb <= m_maxRb; ++nRb)
+      {
+        map.push_back (nRb - 1);
+        for (uint32_t mcs = 0; mcs < N_MCS; ++mcs)
+          {
+            uint16_t size = amc->GetDlTbSizeFromMcs (mcs, nRb) / 8;
+            for (uint32_t s = 0; s < m_nSinr; ++s)
+              {
+                (*sinr) = std::pow (10.0, (m_minDb + s * m_stepDb) / 10);
+                if (nRb == 1)
+                  {
+                    mi[mcs * m_nSinr + s] = LteMiErrorModel::Mib (*sinr, map, mcs);
+                  }
+                bler[(static_cast<size_t> (mcs) * m_maxRb + nRb - 1) * m_nSinr + s] =
+                  LteMiErrorModel::GetTbDecodificationStats (*sinr, map, size, mcs, HarqProcessInfoList_t ()).tbler;
+              }
+          }
+      }
+    SetTables (&m_table[0]);
+  }
+
+  /// the header of the table file
+  struct Header
+  {
+    char magic[8];
+    uint32_t nMcs;
+    uint32_t maxRb;
+    uint32_t nSinr;
+    double minDb;
+    double stepDb;
+  };
+
+  Header GetHeader () const
+  {
+    Header h;
+    std::memset (&h, 0, sizeof (h));
+    std::memcpy (h.magic, "LTEFEML1", 8);
+    h.nMcs = N_MCS;
+    h.maxRb = m_maxRb;
+    h.nSinr = m_nSinr;
+    h.minDb = m_minDb;
+    h.stepDb = m_stepDb;
+    return h;
+  }
+
+  /// \return true if file holds tables of these dimensions, now mapped
+  bool Map (const std::string &file)
+  {
+    int fd = open (file.c_str (), O_RDONLY);
+    if (fd < 0)
+      {
+        return false;
+      }
+    struct stat st;
+    size_t size = sizeof (Header) + GetTableSize () * sizeof (float);
+    if (fstat (fd, &st) != 0 || static_cast<size_t> (st.st_size) != size)
+      {
+        close (fd);
+        return false;
+      }
+    void *map = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (map == MAP_FAILED)
+      {
+        return false;
+      }
+    Header expected = GetHeader ();
+    if (std::memcmp (map, &expected, sizeof (Header)) != 0)
+      {
+        munmap (map, size);
+        return false;
+      }
+    if (m_map)
+      {
+        munmap (m_map, m_mapSize);
+      }
+    m_map = map;
+    m_mapSize = size;
+    SetTables (reinterpret_cast<const float *> (static_cast<const char *> (map) + sizeof (Header)));
+    return true;
+  }
+
+  void Write (const std::string &file) const
+  {
+    // write aside, under a name of this process, and rename, so concurrent
+    // runs never map a partial table
+    std::ostringstream tmpFile;
+    tmpFile << file << "." << getpid () << ".tmp";
+    std::string tmp = tmpFile.str ();
+    std::ofstream out (tmp.c_str (), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    Header h = GetHeader ();
+    out.write (reinterpret_cast<const char *> (&h), sizeof (h));
+    out.write (reinterpret_cast<const char *> (&m_table[0]), m_table.size () * sizeof (float));
+    out.close ();
+    if (out)
+      {
+        std::rename (tmp.c_str (), file.c_str ());
+      }
+    else
+      {
+        std::remove (tmp.c_str ());
+      }
+  }
+
+  uint16_t m_maxRb;
+  uint32_t m_nSinr;
+  double m_minDb;
+  double m_stepDb;
+  std::vector<float> m_table;  ///< tables computed in memory, empty when mapped
+  void *m_map;
+  size_t m_mapSize;
+  const float *m_mi;
+  const float *m_bler;
+};
+
+} // namespace ns3
+
+#endif /* LTE_FAST_ERROR_MODEL_H */
@@ -0,0 +1,172 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef LTE_INTERFERENCE_CULLING_H
+#define LTE_INTERFERENCE_CULLING_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/lte-module.h>
+#include <ns3/spectrum-module.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * Culling of negligible signals in the LTE spectrum channels.
+ *
+ * The spectrum channel drops every signal whose pathloss exceeds its
+ * MaxLossDb attribute before any per-receiver processing.  Install ()
+ * sets it, for each direction, so that a signal is dropped when its power
+ * in one RB would be more than marginDb below the thermal noise of the
+ * receiver in one RB: the downlink from the eNB power per RB and the UE
+ * noise figure, the uplink from the full UE power in a single RB (the
+ * worst case) and the eNB noise figure.
+ *
+ * The channels' PathLoss trace is used to count delivered and dropped
+ * signals and to estimate the power per RB that was dropped, so that the
+ * accuracy impact of the margin can be checked with Report ().
+ */
+class LteInterferenceCulling : public SimpleRefCount<LteInterferenceCulling>
+{
+public:
+  /// \param marginDb how far below the noise floor a signal must be to be dropped
+  explicit LteInterferenceCulling (double marginDb)
+    : m_marginDb (marginDb)
+  {
+  }
+
+  /**
+   * Set MaxLossDb on the channels of lteHelper and connect the counters;
+   * call after the eNB and UE devices have been installed.
+   */
+  void Install (Ptr<LteHelper> lteHelper, NetDeviceContainer enbDevs, NetDeviceContainer ueDevs)
+  {
+    double maxEnbRbDbm = -std::numeric_limits<double>::infinity ();
+    double maxUeDbm = -std::numeric_limits<double>::infinity ();
+    double minEnbNf = std::numeric_limits<double>::infinity ();
+    double minUeNf = std::numeric_limits<double>::infinity ();
+    for (uint32_t i = 0; i < enbDevs.GetN (); ++i)
+      {
+        Ptr<LteEnbNetDevice> enbDev = enbDevs.Get (i)->GetObject<LteEnbNetDevice> ();
+        Ptr<LteEnbPhy> phy = enbDev->GetPhy ();
+        double rbDbm = phy->GetTxPower () - 10 * std::log10 (enbDev->GetDlBandwidth ());
+        m_txRbPowerW[PeekPointer (phy->GetDownlinkSpectrumPhy ())] = DbmToW (rbDbm);
+        maxEnbRbDbm = std::max (maxEnbRbDbm, rbDbm);
+        minEnbNf = std::min (minEnbNf, phy->GetNoiseFigure ());
+      }
+    for (uint32_t i = 0; i < ueDevs.GetN (); ++i)
+      {
+        Ptr<LteUePhy> phy = ueDevs.Get (i)->GetObject<LteUeNetDevice> ()->GetPhy ();
+        m_txRbPowerW[PeekPointer (phy->GetUplinkSpectrumPhy ())] = DbmToW (phy->GetTxPower ());
+        maxUeDbm = std::max (maxUeDbm, phy->GetTxPower ());
+        minUeNf = std::min (minUeNf, phy->GetNoiseFigure ());
+      }
+
+    m_dl.noiseRbW = DbmToW (GetNoiseRbDbm (minUeNf));
+    m_ul.noiseRbW = DbmToW (GetNoiseRbDbm (minEnbNf));
+    m_dl.maxLossDb = maxEnbRbDbm - GetNoiseRbDbm (minUeNf) + m_marginDb;
+    m_ul.maxLossDb = maxUeDbm - GetNoiseRbDbm (minEnbNf) + m_marginDb;
+
+    Ptr<SpectrumChannel> dl = lteHelper->GetDownlinkSpectrumChannel ();
+    Ptr<SpectrumChannel> ul = lteHelper->GetUplinkSpectrumChannel ();
+    dl->SetAttribute ("MaxLossDb", DoubleValue (m_dl.maxLossDb));
+    ul->SetAttribute ("MaxLossDb", DoubleValue (m_ul.maxLossDb));
+    dl->TraceConnectWithoutContext ("PathLoss", MakeBoundCallback (&LteInterferenceCulling::PathLoss, this, &m_dl));
+    ul->TraceConnectWithoutContext ("PathLoss", MakeBoundCallback (&LteInterferenceCulling::PathLoss, this, &m_ul));
+  }
+
+  /// Write the culling thresholds and the counters of both directions
+  void Report (std::ostream &os) const
+  {
+    ReportDirection (os, "DL", m_dl);
+    ReportDirection (os, "UL", m_ul);
+  }
+
+private:
+  /// counters of one direction
+  struct Direction
+  {
+    Direction ()
+      : maxLossDb (0), noiseRbW (0), delivered (0), dropped (0), droppedRbW (0), maxDroppedRbW (0)
+    {
+    }
+    double maxLossDb;
+    double noiseRbW;       ///< thermal noise in one RB at the receivers [W]
+    uint64_t delivered;
+    uint64_t dropped;
+    double droppedRbW;     ///< sum over dropped signals of their power in one RB [W]
+    double maxDroppedRbW;
+  };
+
+  static double DbmToW (double dbm)
+  {
+    return std::pow (10.0, (dbm - 30) / 10);
+  }
+
+  /// kT of -174 dBm/Hz over one RB plus the noise figure
+  static double GetNoiseRbDbm (double noiseFigureDb)
+  {
+    return -174.0 + 10 * std::log10 (180000.0) + noiseFigureDb;
+  }
+
+  static void PathLoss (LteInterferenceCulling *culling, Direction *d,
+                        Ptr<const SpectrumPhy> txPhy, Ptr<const SpectrumPhy> rxPhy, double lossDb)
+  {
+    if (lossDb <= d->maxLossDb)
+      {
+        ++d->delivered;
+        return;
+      }
+    ++d->dropped;
+    std::map<const SpectrumPhy *, double>::const_iterator it = culling->m_txRbPowerW.find (PeekPointer (txPhy));
+    if (it != culling->m_txRbPowerW.end ())
+      {
+        double rbW = it->second * std::pow (10.0, -lossDb / 10);
+        d->droppedRbW += rbW;
+        d->maxDroppedRbW = std::max (d->maxDroppedRbW, rbW);
+      }
+  }
+
+  void ReportDirection (std::ostream &os, const char *name, const Direction &d) const
+  {
+    uint64_t total = d.delivered + d.dropped;
+    os << name << " culling: MaxLossDb " << d.maxLossDb
+       << ", dropped " << d.dropped << " of " << total << " signals";
+    if (d.dropped > 0)
+      {
+        os << ", mean dropped power per RB " << 10 * std::log10 (d.droppedRbW / d.dropped / d.noiseRbW)
+           << " dB and max " << 10 * std::log10 (d.maxDroppedRbW / d.noiseRbW) << " dB relative to noise";
+      }
+    os << "\n";
+  }
+
+  double m_marginDb;
+  std::map<const SpectrumPhy *, double> m_txRbPowerW; ///< bound on the power per RB of each transmitter
+  Direction m_dl;
+  Direction m_ul;
+};
+
+} // namespace ns3
+
+#endif /* LTE_INTERFERENCE_CULLING_H */
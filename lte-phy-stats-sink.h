@@ -0,0 +1,268 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef LTE_PHY_STATS_SINK_H
+#define LTE_PHY_STATS_SINK_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/lte-module.h>
+#include <ns3/spectrum-value.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/// Running summary of a sampled quantity
+struct PhyStatsSummary
+{
+  PhyStatsSummary ()
+    : count (0),
+      sum (0.0),
+      min (std::numeric_limits<double>::infinity ()),
+      max (-std::numeric_limits<double>::infinity ()),
+      last (0.0)
+  {
+  }
+
+  void Add (double v)
+  {
+    ++count;
+    sum += v;
+    min = std::min (min, v);
+    max = std::max (max, v);
+    last = v;
+  }
+
+  void Merge (const PhyStatsSummary &o)
+  {
+    count += o.count;
+    sum += o.sum;
+    min = std::min (min, o.min);
+    max = std::max (max, o.max);
+    if (o.count > 0)
+      {
+        last = o.last;
+      }
+  }
+
+  double Mean () const
+  {
+    return count > 0 ? sum / count : 0.0;
+  }
+
+  uint64_t count;
+  double sum;
+  double min;
+  double max;
+  double last;
+};
+
+/**
+ * In-memory consumer of the LTE PHY measurement traces.
+ *
+ * Hooks the same trace sources that PhyStatsCalculator writes to
+ * DlRsrpSinrStats.txt, UlSinrStats.txt and UlInterferenceStats.txt, and
+ * accumulates them per (IMSI, cell) and per cell instead of formatting
+ * them as text.  Query the results once Simulator::Run () has returned.
+ * All SINR values are linear, RSRP is in W and interference is in W/Hz,
+ * as in the text traces.
+ */
+class LtePhyStatsSink : public SimpleRefCount<LtePhyStatsSink>
+{
+public:
+  typedef std::pair<uint64_t, uint16_t> ImsiCellId;
+
+  /**
+   * Connect to the PHY traces of the given devices and to the RRC traces
+   * of the eNBs, which are needed to map uplink RNTIs to IMSIs.
+   */
+  void Install (NetDeviceContainer enbDevs, NetDeviceContainer ueDevs)
+  {
+    for (uint32_t i = 0; i < ueDevs.GetN (); ++i)
+      {
+        Ptr<LteUeNetDevice> ueDev = ueDevs.Get (i)->GetObject<LteUeNetDevice> ();
+        NS_ASSERT (ueDev);
+        ueDev->GetPhy ()->TraceConnectWithoutContext ("ReportCurrentCellRsrpSinr",
+                                                      MakeBoundCallback (&LtePhyStatsSink::DlRsrpSinr, this, ueDev->GetImsi ()));
+      }
+    for (uint32_t i = 0; i < enbDevs.GetN (); ++i)
+      {
+        Ptr<LteEnbNetDevice> enbDev = enbDevs.Get (i)->GetObject<LteEnbNetDevice> ();
+        NS_ASSERT (enbDev);
+        enbDev->GetPhy ()->TraceConnectWithoutContext ("ReportUeSinr",
+                                                       MakeBoundCallback (&LtePhyStatsSink::UlSinr, this));
+        enbDev->GetPhy ()->TraceConnectWithoutContext ("ReportInterference",
+                                                       MakeBoundCallback (&LtePhyStatsSink::UlInterference, this));
+        enbDev->GetRrc ()->TraceConnectWithoutContext ("ConnectionEstablished",
+                                                       MakeBoundCallback (&LtePhyStatsSink::UeAssociated, this));
+        enbDev->GetRrc ()->TraceConnectWithoutContext ("HandoverEndOk",
+                                                       MakeBoundCallback (&LtePhyStatsSink::UeAssociated, this));
+      }
+  }
+
+  /// \return the IMSIs that reported downlink measurements
+  std::vector<uint64_t> GetImsis () const
+  {
+    std::vector<uint64_t> imsis;
+    for (std::map<ImsiCellId, PhyStatsSummary>::const_iterator it = m_dlSinr.begin (); it != m_dlSinr.end (); ++it)
+      {
+        if (imsis.empty () || imsis.back () != it->first.first)
+          {
+            imsis.push_back (it->first.first);
+          }
+      }
+    return imsis;
+  }
+
+  /// \return the cells that reported uplink interference
+  std::vector<uint16_t> GetCellIds () const
+  {
+    std::vector<uint16_t> cellIds;
+    for (std::map<uint16_t, InterferenceStats>::const_iterator it = m_ulInterference.begin (); it != m_ulInterference.end (); ++it)
+      {
+        cellIds.push_back (it->first);
+      }
+    return cellIds;
+  }
+
+  /// RSRP of the serving cell cellId as measured by UE imsi
+  PhyStatsSummary GetDlRsrp (uint64_t imsi, uint16_t cellId) const
+  {
+    return Find (m_dlRsrp, ImsiCellId (imsi, cellId));
+  }
+
+  /// Downlink SINR of UE imsi while served by cellId
+  PhyStatsSummary GetDlSinr (uint64_t imsi, uint16_t cellId) const
+  {
+    return Find (m_dlSinr, ImsiCellId (imsi, cellId));
+  }
+
+  /// Uplink SINR of UE imsi as measured by cellId
+  PhyStatsSummary GetUlSinr (uint64_t imsi, uint16_t cellId) const
+  {
+    return Find (m_ulSinr, ImsiCellId (imsi, cellId));
+  }
+
+  /// Uplink interference of cellId averaged over all RBs
+  PhyStatsSummary GetUlInterference (uint16_t cellId) const
+  {
+    std::map<uint16_t, InterferenceStats>::const_iterator it = m_ulInterference.find (cellId);
+    return it == m_ulInterference.end () ? PhyStatsSummary () : it->second.total;
+  }
+
+  /// Mean uplink interference of cellId on each RB
+  std::vector<double> GetUlInterferencePerRb (uint16_t cellId) const
+  {
+    std::vector<double> mean;
+    std::map<uint16_t, InterferenceStats>::const_iterator it = m_ulInterference.find (cellId);
+    if (it != m_ulInterference.end ())
+      {
+        for (size_t rb = 0; rb < it->second.perRb.size (); ++rb)
+          {
+            mean.push_back (it->second.perRb[rb].Mean ());
+          }
+      }
+    return mean;
+  }
+
+private:
+  typedef std::pair<uint16_t, uint16_t> CellIdRnti;
+
+  struct InterferenceStats
+  {
+    PhyStatsSummary total;
+    std::vector<PhyStatsSummary> perRb;
+  };
+
+  static PhyStatsSummary Find (const std::map<ImsiCellId, PhyStatsSummary> &m, ImsiCellId key)
+  {
+    std::map<ImsiCellId, PhyStatsSummary>::const_iterator it = m.find (key);
+    return it == m.end () ? PhyStatsSummary () : it->second;
+  }
+
+  static void DlRsrpSinr (LtePhyStatsSink *sink, uint64_t imsi,
+                          uint16_t cellId, uint16_t rnti, double rsrp, double sinr, uint8_t componentCarrierId)
+  {
+    sink->m_dlRsrp[ImsiCellId (imsi, cellId)].Add (rsrp);
+    sink->m_dlSinr[ImsiCellId (imsi, cellId)].Add (sinr);
+  }
+
+  static void UlSinr (LtePhyStatsSink *sink,
+                      uint16_t cellId, uint16_t rnti, double sinrLinear, uint8_t componentCarrierId)
+  {
+    std::map<CellIdRnti, uint64_t>::const_iterator it = sink->m_imsiByRnti.find (CellIdRnti (cellId, rnti));
+    if (it != sink->m_imsiByRnti.end ())
+      {
+        sink->m_ulSinr[ImsiCellId (it->second, cellId)].Add (sinrLinear);
+      }
+    else
+      {
+        // SRS may be measured before the RRC connection is reported
+        sink->m_pendingUlSinr[CellIdRnti (cellId, rnti)].Add (sinrLinear);
+      }
+  }
+
+  static void UlInterference (LtePhyStatsSink *sink, uint16_t cellId, Ptr<SpectrumValue> interference)
+  {
+    InterferenceStats &stats = sink->m_ulInterference[cellId];
+    size_t nRbs = interference->GetValuesN ();
+    if (stats.perRb.size () < nRbs)
+      {
+        stats.perRb.resize (nRbs);
+      }
+    double sum = 0.0;
+    for (size_t rb = 0; rb < nRbs; ++rb)
+      {
+        double v = (*interference)[rb];
+        stats.perRb[rb].Add (v);
+        sum += v;
+      }
+    if (nRbs > 0)
+      {
+        stats.total.Add (sum / nRbs);
+      }
+  }
+
+  static void UeAssociated (LtePhyStatsSink *sink, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+  {
+    CellIdRnti key (cellId, rnti);
+    sink->m_imsiByRnti[key] = imsi;
+    std::map<CellIdRnti, PhyStatsSummary>::iterator it = sink->m_pendingUlSinr.find (key);
+    if (it != sink->m_pendingUlSinr.end ())
+      {
+        sink->m_ulSinr[ImsiCellId (imsi, cellId)].Merge (it->second);
+        sink->m_pendingUlSinr.erase (it);
+      }
+  }
+
+  std::map<ImsiCellId, PhyStatsSummary> m_dlRsrp;
+  std::map<ImsiCellId, PhyStatsSummary> m_dlSinr;
+  std::map<ImsiCellId, PhyStatsSummary> m_ulSinr;
+  std::map<CellIdRnti, PhyStatsSummary> m_pendingUlSinr;
+  std::map<CellIdRnti, uint64_t> m_imsiByRnti;
+  std::map<uint16_t, InterferenceStats> m_ulInterference;
+};
+
+} // namespace ns3
+
+#endif /* LTE_PHY_STATS_SINK_H */
@@ -0,0 +1,680 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef LTE_REM_CUBE_H
+#define LTE_REM_CUBE_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/lte-module.h>
+#include <ns3/antenna-module.h>
+#include <ns3/propagation-module.h>
+#include <ns3/spectrum-module.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "enb-spatial-index.h"
+#include "sim-process-pool.h"
+
+namespace ns3 {
+
+/**
+ * Downlink SINR of every RB at every point of a regular grid, computed in
+ * one pass and written as a binary (x, y, RB) cube.
+ *
+ * Unlike RadioEnvironmentMapHelper, which measures the signals actually
+ * sent on the channel and so yields one RB (or the RB average) per run,
+ * the cube is computed directly: for every point and eNB the pathloss and
+ * antenna gain are evaluated once with the channel's propagation loss
+ * model, and then scaled by the eNB's transmit power on each RB.  The SINR
+ * of an RB is the strongest signal over the sum of the others plus noise,
+ * as in RemSpectrumPhy.
+ *
+ * The gain of one transmitter over the whole grid is a layer.  With a
+ * cache directory set, layers are stored there under a hash of the
+ * transmitter position, its antenna, the pathloss model and the grid, and
+ * only layers that are not found are computed.  Transmit power and FFR
+ * masks are applied when the layers are combined, so changing them never
+ * invalidates the cache.
+ *
+ * With a maximum distance set, a layer only covers the bounding box of
+ * the grid points within that distance of its transmitter, in memory and
+ * in the cache, and combining a point only visits the transmitters an
+ * EnbSpatialIndex finds within reach, so large layouts cost time, memory
+ * and disk in proportion to the eNBs near each point rather than all of
+ * them.
+ *
+ * File layout (host byte order):
+ *
+ *   char[8]  magic "LTEREMC1"
+ *   uint32   nX, nY, nRb
+ *   double   xMin, xMax, yMin, yMax, z
+ *   float    SINR (linear) [nX][nY][nRb], RB index varying fastest
+ */
+class LteRemCube
+{
+public:
+  /**
+   * \param box area covered by the grid (z is taken from box.zMin)
+   * \param res number of grid steps along each axis, i.e. res + 1 points
+   */
+  LteRemCube (Box box, uint16_t res)
+    : m_box (box),
+      m_res (res),
+      m_nRb (0),
+      m_maxDistance (0),
+      m_noisePowerPerRb (std::pow (10.0, (-174.0 + 9.0 - 30.0) / 10.0) * 180000)
+  {
+  }
+
+  /**
+   * Add the downlink transmitters of enbDevs.
+   * \param applyFfrMask if true, only the RBGs the FFR algorithm of each
+   *        eNB makes available for its downlink carry power
+   */
+  void AddEnbs (NetDeviceContainer enbDevs, bool applyFfrMask)
+  {
+    for (uint32_t i = 0; i < enbDevs.GetN (); ++i)
+      {
+        Ptr<LteEnbNetDevice> enbDev = enbDevs.Get (i)->GetObject<LteEnbNetDevice> ();
+        NS_ASSERT (enbDev);
+        uint16_t nRb = enbDev->GetDlBandwidth ();
+        NS_ABORT_MSG_IF (m_nRb != 0 && m_nRb != nRb, "all eNBs must use the same DL bandwidth");
+        m_nRb = nRb;
+
+        std::vector<int> activeRbs;
+        std::vector<bool> unavailableRbg;
+        if (applyFfrMask)
+          {
+            unavailableRbg = enbDev->GetFfrAlgorithm ()->GetLteFfrSapProvider ()->GetAvailableDlRbg ();
+          }
+        int rbgSize = GetRbgSize (nRb);
+        for (int rb = 0; rb < nRb; ++rb)
+          {
+            size_t rbg = rb / rbgSize;
+            if (rbg >= unavailableRbg.size () || !unavailableRbg[rbg])
+              {
+                activeRbs.push_back (rb);
+              }
+          }
+
+        Ptr<LteEnbPhy> phy = enbDev->GetPhy ();
+        Ptr<SpectrumValue> psd = LteSpectrumValueHelper::CreateTxPowerSpectralDensity (enbDev->GetDlEarfcn (), nRb,
+                                                                                      phy->GetTxPower (), activeRbs);
+        Transmitter tx;
+        tx.mobility = enbDev->GetNode ()->GetObject<MobilityModel> ();
+        tx.antenna = DynamicCast<AntennaModel> (phy->GetDownlinkSpectrumPhy ()->GetAntenna ());
+        tx.hasLayer = false;
+        for (int rb = 0; rb < nRb; ++rb)
+          {
+            tx.rbPower.push_back ((*psd)[rb] * 180000);
+          }
+        m_txs.push_back (tx);
+
+        if (!m_loss)
+          {
+            m_loss = phy->GetDownlinkSpectrumPhy ()->GetChannel ()->GetPropagationLossModel ();
+          }
+      }
+  }
+
+  /// Set the receiver noise power in one RB [W]
+  void SetNoisePowerPerRb (double noisePower)
+  {
+    m_noisePowerPerRb = noisePower;
+  }
+
+  /// Ignore transmitters farther than distance from a point [m]; 0 keeps all of them
+  void SetMaxDistance (double distance)
+  {
+    m_maxDistance = distance;
+  }
+
+  /// Keep the per-transmitter gain layers in dir; empty disables the cache
+  void SetCacheDirectory (const std::string &dir)
+  {
+    m_cacheDir = dir;
+  }
+
+  /**
+   * Load the gain layers from the cache and compute the missing ones.
+   * Generate () and WriteRem () call it when needed.
+   * \param jobs number of worker processes, 0 for one per CPU
+   * \return the number of layers that had to be computed
+   */
+  uint32_t LoadLayers (uint32_t jobs)
+  {
+    NS_ABORT_MSG_IF (m_txs.empty () || !m_loss, "no transmitters");
+    uint32_t nColumns = m_res + 1;
+    if (!m_cacheDir.empty ())
+      {
+        mkdir (m_cacheDir.c_str (), 0755);
+      }
+
+    std::vector<size_t> missing;
+    std::vector<std::string> layerFiles (m_txs.size ());
+    for (size_t k = 0; k < m_txs.size (); ++k)
+      {
+        if (m_txs[k].hasLayer)
+          {
+            continue;
+          }
+        SetLayerBox (k);
+        std::ostringstream name;
+        name << std::hex << GetLayerHash (k);
+        layerFiles[k] = m_cacheDir.empty () ? "" : m_cacheDir + "/" + name.str () + ".remlayer";
+        if (layerFiles[k].empty () || !ReadLayer (layerFiles[k], m_txs[k]))
+          {
+            missing.push_back (k);
+          }
+        m_txs[k].hasLayer = true;
+      }
+    if (missing.empty ())
+      {
+        return 0;
+      }
+
+    // one job per column tile computes every missing layer on its columns,
+    // written one layer after the other to a single tile file
+    SimProcessPool pool (jobs);
+    uint32_t nTiles = std::min (pool.GetMaxWorkers () * 4, nColumns);
+    std::vector<std::string> tileFiles;
+    for (uint32_t t = 0; t < nTiles; ++t)
+      {
+        uint32_t first = t * nColumns / nTiles;
+        uint32_t last = (t + 1) * nColumns / nTiles;
+        std::ostringstream tileFile;
+        tileFile << "rem-layers.tile" << t;
+        std::string file = GetTempFile (tileFile.str ());
+        tileFiles.push_back (file);
+        pool.Submit ([this, &missing, first, last, file] (std::ostream &)
+          {
+            std::ofstream out (file.c_str (), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+            for (size_t m = 0; m < missing.size (); ++m)
+              {
+                ComputeLayerColumns (missing[m], first, last, out);
+              }
+          });
+      }
+    std::vector<SimProcessPool::JobResult> results = pool.Run ();
+
+    for (size_t m = 0; m < missing.size (); ++m)
+      {
+        m_txs[missing[m]].gain.assign (GetLayerSize (m_txs[missing[m]]), 0.0f);
+      }
+    for (uint32_t t = 0; t < nTiles; ++t)
+      {
+        NS_ABORT_MSG_IF (!results[t].Ok (), "REM layer tile " << t << " failed with status " << results[t].status);
+        uint32_t first = t * nColumns / nTiles;
+        uint32_t last = (t + 1) * nColumns / nTiles;
+        std::ifstream tile (tileFiles[t].c_str (), std::ios_base::in | std::ios_base::binary);
+        for (size_t m = 0; m < missing.size (); ++m)
+          {
+            Transmitter &tx = m_txs[missing[m]];
+            uint32_t i0 = std::max (first, tx.iMin);
+            uint32_t i1 = std::min (last, tx.iMax);
+            if (i0 < i1 && tx.jMin < tx.jMax)
+              {
+                size_t rows = tx.jMax - tx.jMin;
+                tile.read (reinterpret_cast<char *> (&tx.gain[(i0 - tx.iMin) * rows]), (i1 - i0) * rows * sizeof (float));
+              }
+          }
+        NS_ABORT_MSG_IF (!tile, "short REM layer tile " << tileFiles[t]);
+        tile.close ();
+        std::remove (tileFiles[t].c_str ());
+      }
+    for (size_t m = 0; m < missing.size (); ++m)
+      {
+        if (!layerFiles[missing[m]].empty ())
+          {
+            WriteLayer (layerFiles[missing[m]], m_txs[missing[m]]);
+          }
+      }
+    return missing.size ();
+  }
+
+  /**
+   * Compute the cube and write it to filename.
+   * \param jobs number of worker processes, 0 for one per CPU
+   */
+  void Generate (const std::string &filename, uint32_t jobs)
+  {
+    LoadLayers (jobs);
+    uint32_t nColumns = m_res + 1;
+    SimProcessPool pool (jobs);
+    uint32_t nTiles = std::min (pool.GetMaxWorkers () * 4, nColumns);
+
+    std::vector<std::string> tileFiles;
+    for (uint32_t t = 0; t < nTiles; ++t)
+      {
+        uint32_t first = t * nColumns / nTiles;
+        uint32_t last = (t + 1) * nColumns / nTiles;
+        std::ostringstream tileFile;
+        tileFile << filename << ".tile" << t << "." << getpid () << ".tmp";
+        tileFiles.push_back (tileFile.str ());
+        std::string file = tileFile.str ();
+        pool.Submit ([this, first, last, file] (std::ostream &)
+          {
+            std::ofstream out (file.c_str (), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+            ComputeColumns (first, last, out);
+          });
+      }
+    std::vector<SimProcessPool::JobResult> results = pool.Run ();
+
+    std::ofstream out (filename.c_str (), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    NS_ABORT_MSG_IF (!out.is_open (), "Can't open file " << filename);
+    uint32_t dims[3] = {nColumns, nColumns, m_nRb};
+    double bounds[5] = {m_box.xMin, m_box.xMax, m_box.yMin, m_box.yMax, m_box.zMin};
+    out.write ("LTEREMC1", 8);
+    out.write (reinterpret_cast<const char *> (dims), sizeof (dims));
+    out.write (reinterpret_cast<const char *> (bounds), sizeof (bounds));
+    for (uint32_t t = 0; t < nTiles; ++t)
+      {
+        NS_ABORT_MSG_IF (!results[t].Ok (), "REM cube tile " << t << " failed with status " << results[t].status);
+        std::ifstream tile (tileFiles[t].c_str (), std::ios_base::in | std::ios_base::binary);
+        out << tile.rdbuf ();
+        tile.close ();
+        std::remove (tileFiles[t].c_str ());
+      }
+  }
+
+  /**
+   * Write a text REM in the format of RadioEnvironmentMapHelper: one
+   * "x y z sinr" line per point.
+   * \param rbId RB to map, or -1 for the SINR of the total received power
+   * \param noisePower noise power in the measured band [W]
+   * \param jobs number of worker processes for missing layers
+   */
+  void WriteRem (const std::string &filename, int32_t rbId, double noisePower, uint32_t jobs)
+  {
+    LoadLayers (jobs);
+    std::ofstream out (filename.c_str ());
+    NS_ABORT_MSG_IF (!out.is_open (), "Can't open file " << filename);
+
+    std::vector<double> txPower;
+    for (size_t k = 0; k < m_txs.size (); ++k)
+      {
+        double p = 0;
+        for (uint16_t rb = 0; rb < m_nRb; ++rb)
+          {
+            if (rbId < 0 || rb == rbId)
+              {
+                p += m_txs[k].rbPower[rb];
+              }
+          }
+        txPower.push_back (p);
+      }
+
+    double step = (m_box.xMax - m_box.xMin) / m_res;
+    double yStep = (m_box.yMax - m_box.yMin) / m_res;
+    EnbSpatialIndex index (GetTxPositions ());
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i <= m_res; ++i)
+      {
+        for (uint32_t j = 0; j <= m_res; ++j)
+          {
+            GetCandidates (index, GetPoint (i, j), candidates);
+            double total = 0;
+            double best = 0;
+            for (size_t c = 0; c < candidates.size (); ++c)
+              {
+                uint32_t k = candidates[c];
+                double p = txPower[k] * GetGain (k, i, j);
+                total += p;
+                best = std::max (best, p);
+              }
+            out << m_box.xMin + i * step << "\t" << m_box.yMin + j * yStep << "\t" << m_box.zMin
+                << "\t" << best / (total - best + noisePower) << "\n";
+          }
+      }
+  }
+
+private:
+  struct Transmitter
+  {
+    Ptr<MobilityModel> mobility;
+    Ptr<AntennaModel> antenna;
+    std::vector<double> rbPower; ///< transmit power on each RB [W]
+    bool hasLayer;               ///< gain holds the layer
+    uint32_t iMin, iMax;         ///< grid columns of the layer, iMax excluded
+    uint32_t jMin, jMax;         ///< grid rows of the layer, jMax excluded
+    std::vector<float> gain;     ///< linear gain to every point of the layer, x major
+  };
+
+  static size_t GetLayerSize (const Transmitter &tx)
+  {
+    return static_cast<size_t> (tx.iMax - tx.iMin) * (tx.jMax - tx.jMin);
+  }
+
+  /// \return the gain of transmitter k to grid point (i, j), 0 outside its layer
+  float GetGain (size_t k, uint32_t i, uint32_t j) const
+  {
+    const Transmitter &tx = m_txs[k];
+    if (i < tx.iMin || i >= tx.iMax || j < tx.jMin || j >= tx.jMax)
+      {
+        return 0.0f;
+      }
+    return tx.gain[static_cast<size_t> (i - tx.iMin) * (tx.jMax - tx.jMin) + j - tx.jMin];
+  }
+
+  /**
+   * Set the layer of transmitter k to the whole grid, or with a maximum
+   * distance to the grid points in the bounding box of that distance.
+   * The box is rounded outwards; the points it holds beyond the distance
+   * are never read.
+   */
+  void SetLayerBox (size_t k)
+  {
+    Transmitter &tx = m_txs[k];
+    tx.iMin = tx.jMin = 0;
+    tx.iMax = tx.jMax = m_res + 1;
+    if (m_maxDistance <= 0)
+      {
+        return;
+      }
+    Vector p = tx.mobility->GetPosition ();
+    GetGridRange (p.x - m_maxDistance, p.x + m_maxDistance, m_box.xMin, m_box.xMax, tx.iMin, tx.iMax);
+    GetGridRange (p.y - m_maxDistance, p.y + m_maxDistance, m_box.yMin, m_box.yMax, tx.jMin, tx.jMax);
+  }
+
+  /// Set [first, last) to the indices of the grid steps of [min, max] that cover [lo, hi]
+  void GetGridRange (double lo, double hi, double min, double max, uint32_t &first, uint32_t &last) const
+  {
+    double step = (max - min) / m_res;
+    double a = std::max (std::floor ((lo - min) / step), 0.0);
+    double b = std::min (std::ceil ((hi - min) / step) + 1, static_cast<double> (m_res + 1));
+    first = static_cast<uint32_t> (std::min (a, static_cast<double> (m_res + 1)));
+    last = std::max (first, static_cast<uint32_t> (std::max (b, 0.0)));
+  }
+
+  /// \return grid point (i, j)
+  Vector GetPoint (uint32_t i, uint32_t j) const
+  {
+    return Vector (m_box.xMin + i * (m_box.xMax - m_box.xMin) / m_res,
+                   m_box.yMin + j * (m_box.yMax - m_box.yMin) / m_res, m_box.zMin);
+  }
+
+  std::vector<Vector> GetTxPositions () const
+  {
+    std::vector<Vector> positions;
+    for (size_t k = 0; k < m_txs.size (); ++k)
+      {
+        positions.push_back (m_txs[k].mobility->GetPosition ());
+      }
+    return positions;
+  }
+
+  /// Set candidates to the transmitters that reach point
+  void GetCandidates (const EnbSpatialIndex &index, const Vector &point, std::vector<uint32_t> &candidates) const
+  {
+    if (m_maxDistance > 0)
+      {
+        candidates = index.FindWithin (point, m_maxDistance);
+        return;
+      }
+    candidates.resize (m_txs.size ());
+    for (size_t k = 0; k < m_txs.size (); ++k)
+      {
+        candidates[k] = k;
+      }
+  }
+
+  /// RBG size for a bandwidth in RBs, 3GPP TS 36.213 table 7.1.6.1-1
+  static int GetRbgSize (uint16_t nRb)
+  {
+    return nRb <= 10 ? 1 : nRb <= 26 ? 2 : nRb <= 63 ? 3 : 4;
+  }
+
+  /**
+   * Write the type and attribute values of obj.  Pointer and container
+   * attributes are left out: they print addresses, which change per run.
+   */
+  static void DescribeObject (std::ostream &os, Ptr<Object> obj)
+  {
+    if (!obj)
+      {
+        os << "none;";
+        return;
+      }
+    TypeId tid = obj->GetInstanceTypeId ();
+    os << tid.GetName ();
+    while (true)
+      {
+        for (uint32_t i = 0; i < tid.GetAttributeN (); ++i)
+          {
+            struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+            if (!(info.flags & TypeId::ATTR_GET) || !info.accessor->HasGetter ())
+              {
+                continue;
+              }
+            Ptr<AttributeValue> value = info.checker->Create ();
+            if (DynamicCast<PointerValue> (value) || DynamicCast<ObjectPtrContainerValue> (value))
+              {
+                continue;
+              }
+            if (info.accessor->Get (PeekPointer (obj), *value))
+              {
+                os << " " << info.name << "=" << value->SerializeToString (info.checker);
+              }
+          }
+        if (tid.GetParent () == tid)
+          {
+            break;
+          }
+        tid = tid.GetParent ();
+      }
+    os << ";";
+  }
+
+  /// Hash of everything the gain layer of transmitter k depends on
+  uint64_t GetLayerHash (size_t k) const
+  {
+    std::ostringstream key;
+    key.precision (17);
+    key << "grid " << m_box << " " << m_res << ";";
+    key << "position " << m_txs[k].mobility->GetPosition () << ";";
+    if (m_maxDistance > 0)
+      {
+        key << "maxDistance " << m_maxDistance << ";";
+      }
+    DescribeObject (key, m_txs[k].antenna);
+    for (Ptr<PropagationLossModel> loss = m_loss; loss; loss = loss->GetNext ())
+      {
+        DescribeObject (key, loss);
+      }
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    std::string s = key.str ();
+    for (size_t i = 0; i < s.size (); ++i)
+      {
+        hash ^= static_cast<unsigned char> (s[i]);
+        hash *= 1099511628211ULL;
+      }
+    return hash;
+  }
+
+  /**
+   * \return a file name for name, unique to this process, in the cache
+   * directory, or in the working directory without a cache
+   */
+  std::string GetTempFile (const std::string &name) const
+  {
+    std::ostringstream file;
+    if (!m_cacheDir.empty ())
+      {
+        file << m_cacheDir << "/";
+      }
+    file << name << "." << getpid () << ".tmp";
+    return file.str ();
+  }
+
+  /**
+   * Layer file layout (host byte order):
+   *
+   *   char[8]  magic "LTEREML2"
+   *   uint32   iMin, iMax, jMin, jMax
+   *   float    gain [iMax - iMin][jMax - jMin]
+   *
+   * \return true if file holds the layer of the box of tx, now in tx.gain
+   */
+  bool ReadLayer (const std::string &file, Transmitter &tx) const
+  {
+    std::ifstream in (file.c_str (), std::ios_base::in | std::ios_base::binary);
+    char magic[8];
+    uint32_t box[4];
+    in.read (magic, sizeof (magic));
+    in.read (reinterpret_cast<char *> (box), sizeof (box));
+    if (!in || std::memcmp (magic, "LTEREML2", 8) != 0
+        || box[0] != tx.iMin || box[1] != tx.iMax || box[2] != tx.jMin || box[3] != tx.jMax)
+      {
+        return false;
+      }
+    tx.gain.resize (GetLayerSize (tx));
+    if (!tx.gain.empty ())
+      {
+        in.read (reinterpret_cast<char *> (&tx.gain[0]), tx.gain.size () * sizeof (float));
+      }
+    if (!in)
+      {
+        tx.gain.clear ();
+        return false;
+      }
+    return true;
+  }
+
+  void WriteLayer (const std::string &file, const Transmitter &tx) const
+  {
+    // write aside and rename, so an interrupted run leaves no partial layer
+    // and runs sharing the cache never write the same file
+    std::ostringstream tmpFile;
+    tmpFile << file << "." << getpid () << ".tmp";
+    std::string tmp = tmpFile.str ();
+    std::ofstream out (tmp.c_str (), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    uint32_t box[4] = {tx.iMin, tx.iMax, tx.jMin, tx.jMax};
+    out.write ("LTEREML2", 8);
+    out.write (reinterpret_cast<const char *> (box), sizeof (box));
+    if (!tx.gain.empty ())
+      {
+        out.write (reinterpret_cast<const char *> (&tx.gain[0]), tx.gain.size () * sizeof (float));
+      }
+    out.close ();
+    if (out)
+      {
+        std::rename (tmp.c_str (), file.c_str ());
+      }
+    else
+      {
+        std::remove (tmp.c_str ());
+      }
+  }
+
+  /// Write the gain of transmitter k to the grid columns [first, last) of its layer to out
+  void ComputeLayerColumns (size_t k, uint32_t first, uint32_t last, std::ostream &out)
+  {
+    const Transmitter &tx = m_txs[k];
+    if (tx.jMin >= tx.jMax)
+      {
+        return;
+      }
+    Ptr<ConstantPositionMobilityModel> rx = CreateObject<ConstantPositionMobilityModel> ();
+    Vector txPosition = m_txs[k].mobility->GetPosition ();
+    std::vector<float> column (tx.jMax - tx.jMin);
+    for (uint32_t i = std::max (first, tx.iMin); i < std::min (last, tx.iMax); ++i)
+      {
+        for (uint32_t j = tx.jMin; j < tx.jMax; ++j)
+          {
+            Vector point = GetPoint (i, j);
+            if (m_maxDistance > 0 && CalculateDistance (point, txPosition) > m_maxDistance)
+              {
+                // never read when combining
+                column[j - tx.jMin] = 0;
+                continue;
+              }
+            rx->SetPosition (point);
+            double gainDb = m_loss->CalcRxPower (0.0, m_txs[k].mobility, rx);
+            if (m_txs[k].antenna)
+              {
+                gainDb += m_txs[k].antenna->GetGainDb (Angles (rx->GetPosition (), m_txs[k].mobility->GetPosition ()));
+              }
+            column[j - tx.jMin] = std::pow (10.0, gainDb / 10.0);
+          }
+        out.write (reinterpret_cast<const char *> (&column[0]), column.size () * sizeof (float));
+      }
+  }
+
+  /// Write the SINR of the grid columns [first, last) to out
+  void ComputeColumns (uint32_t first, uint32_t last, std::ostream &out)
+  {
+    std::vector<double> total (m_nRb);
+    std::vector<double> best (m_nRb);
+    std::vector<float> sinr (m_nRb);
+    EnbSpatialIndex index (GetTxPositions ());
+    std::vector<uint32_t> candidates;
+
+    for (uint32_t i = first; i < last; ++i)
+      {
+        for (uint32_t j = 0; j <= m_res; ++j)
+          {
+            std::fill (total.begin (), total.end (), 0.0);
+            std::fill (best.begin (), best.end (), 0.0);
+            GetCandidates (index, GetPoint (i, j), candidates);
+            for (size_t c = 0; c < candidates.size (); ++c)
+              {
+                uint32_t k = candidates[c];
+                double gain = GetGain (k, i, j);
+                for (uint16_t rb = 0; rb < m_nRb; ++rb)
+                  {
+                    double p = m_txs[k].rbPower[rb] * gain;
+                    total[rb] += p;
+                    best[rb] = std::max (best[rb], p);
+                  }
+              }
+            for (uint16_t rb = 0; rb < m_nRb; ++rb)
+              {
+                sinr[rb] = best[rb] / (total[rb] - best[rb] + m_noisePowerPerRb);
+              }
+            out.write (reinterpret_cast<const char *> (&sinr[0]), m_nRb * sizeof (float));
+          }
+      }
+  }
+
+  Box m_box;
+  uint16_t m_res;
+  uint16_t m_nRb;
+  double m_maxDistance;
+  double m_noisePowerPerRb;
+  std::string m_cacheDir;
+  std::vector<Transmitter> m_txs;
+  Ptr<PropagationLossModel> m_loss;
+};
+
+} // namespace ns3
+
+#endif /* LTE_REM_CUBE_H */
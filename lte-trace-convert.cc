@@ -0,0 +1,344 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "binary-trace-format.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LteTraceConvert");
+
+/**
+ * Converts a binary trace table written by LteBinaryTraceHelper back to
+ * the text layout of the corresponding LTE stats calculator output.
+ *
+ *   lte-trace-convert --input=DlRsrpSinr.bin
+ *
+ * RLC and PDCP tables are aggregated per epoch, like
+ * RadioBearerStatsCalculator does, using startTime and epochDuration.
+ * A SpectrumAnalyzer table written by SpectrumAnalyzerTrace is converted
+ * to the ASCII layout of SpectrumAnalyzerHelper for one analyzer.
+ */
+
+/// Running statistics of one RLC/PDCP quantity within an epoch
+struct EpochStats
+{
+  EpochStats ()
+    : n (0), sum (0), sumSq (0),
+      min (std::numeric_limits<double>::max ()),
+      max (0)
+  {
+  }
+  void Add (double v)
+  {
+    ++n;
+    sum += v;
+    sumSq += v * v;
+    min = std::min (min, v);
+    max = std::max (max, v);
+  }
+  double Mean () const
+  {
+    return n > 0 ? sum / n : 0;
+  }
+  double StdDev () const
+  {
+    if (n < 2)
+      {
+        return 0;
+      }
+    double var = (sumSq - sum * sum / n) / (n - 1);
+    return var > 0 ? std::sqrt (var) : 0;
+  }
+  uint64_t n;
+  double sum;
+  double sumSq;
+  double min;
+  double max;
+};
+
+/// Counters of one (IMSI, LCID) bearer within an epoch
+struct BearerEpoch
+{
+  BearerEpoch ()
+    : cellId (0), rnti (0), txPdus (0), txBytes (0), rxPdus (0), rxBytes (0)
+  {
+  }
+  uint16_t cellId;
+  uint16_t rnti;
+  uint32_t txPdus;
+  uint64_t txBytes;
+  uint32_t rxPdus;
+  uint64_t rxBytes;
+  EpochStats delay;
+  EpochStats pduSize;
+};
+
+static void
+WriteEpoch (std::ostream &out, double start, double end,
+            std::map<std::pair<uint64_t, uint8_t>, BearerEpoch> &bearers)
+{
+  for (std::map<std::pair<uint64_t, uint8_t>, BearerEpoch>::iterator it = bearers.begin (); it != bearers.end (); ++it)
+    {
+      const BearerEpoch &b = it->second;
+      out << start << "\t" << end << "\t" << b.cellId << "\t" << it->first.first << "\t" << b.rnti
+          << "\t" << (uint32_t) it->first.second << "\t" << b.txPdus << "\t" << b.txBytes
+          << "\t" << b.rxPdus << "\t" << b.rxBytes
+          << "\t" << b.delay.Mean () << "\t" << b.delay.StdDev ()
+          << "\t" << (b.delay.n ? b.delay.min : 0) << "\t" << b.delay.max
+          << "\t" << b.pduSize.Mean () << "\t" << b.pduSize.StdDev ()
+          << "\t" << (b.pduSize.n ? b.pduSize.min : 0) << "\t" << b.pduSize.max
+          << "\n";
+    }
+  bearers.clear ();
+}
+
+static void
+ConvertBearerTable (BinaryTraceReader &in, std::ostream &out, double startTime, double epochDuration)
+{
+  out << "% start\tend\tCellId\tIMSI\tRNTI\tLCID\tnTxPDUs\tTxBytes\tnRxPDUs\tRxBytes\t"
+      << "delay\tstdDev\tmin\tmax\tPduSize\tstdDev\tmin\tmax\n";
+
+  int time = in.FindColumn ("time");
+  int cellId = in.FindColumn ("cellId");
+  int imsi = in.FindColumn ("imsi");
+  int rnti = in.FindColumn ("rnti");
+  int lcid = in.FindColumn ("lcid");
+  int event = in.FindColumn ("event");
+  int size = in.FindColumn ("size");
+  int delay = in.FindColumn ("delay");
+
+  std::map<std::pair<uint64_t, uint8_t>, BearerEpoch> bearers;
+  double epochEnd = startTime + epochDuration;
+  while (in.NextChunk ())
+    {
+      for (uint32_t r = 0; r < in.GetRows (); ++r)
+        {
+          double t = in.GetUint (time, r) / 1e9;
+          if (t < startTime)
+            {
+              continue;
+            }
+          while (t >= epochEnd)
+            {
+              WriteEpoch (out, epochEnd - epochDuration, epochEnd, bearers);
+              epochEnd += epochDuration;
+            }
+          BearerEpoch &b = bearers[std::make_pair (in.GetUint (imsi, r), (uint8_t) in.GetUint (lcid, r))];
+          b.cellId = in.GetUint (cellId, r);
+          b.rnti = in.GetUint (rnti, r);
+          uint32_t bytes = in.GetUint (size, r);
+          if (in.GetUint (event, r) == 0)
+            {
+              ++b.txPdus;
+              b.txBytes += bytes;
+            }
+          else
+            {
+              ++b.rxPdus;
+              b.rxBytes += bytes;
+              b.delay.Add (in.GetUint (delay, r) * 1e-9);
+              b.pduSize.Add (bytes);
+            }
+        }
+    }
+  WriteEpoch (out, epochEnd - epochDuration, epochEnd, bearers);
+}
+
+static void
+ConvertInterferenceTable (BinaryTraceReader &in, std::ostream &out)
+{
+  out << "% time\tcellId\tInterference\n";
+  int time = in.FindColumn ("time");
+  int cellId = in.FindColumn ("cellId");
+  int value = in.FindColumn ("interference");
+
+  // consecutive rows with the same time and cell form one line
+  bool open = false;
+  uint64_t lastTime = 0;
+  uint64_t lastCell = 0;
+  while (in.NextChunk ())
+    {
+      for (uint32_t r = 0; r < in.GetRows (); ++r)
+        {
+          uint64_t t = in.GetUint (time, r);
+          uint64_t c = in.GetUint (cellId, r);
+          if (!open || t != lastTime || c != lastCell)
+            {
+              if (open)
+                {
+                  out << "\n";
+                }
+              out << t / 1e9 << "\t" << c << "\t";
+              open = true;
+              lastTime = t;
+              lastCell = c;
+            }
+          out << in.GetDouble (value, r) << " ";
+        }
+    }
+  if (open)
+    {
+      out << "\n";
+    }
+}
+
+/**
+ * Convert a table with one text row per binary row.  The first column
+ * is the time in ns and is written in seconds, the others as they are.
+ */
+static void
+ConvertRowTable (BinaryTraceReader &in, std::ostream &out, const std::string &header)
+{
+  out << header << "\n";
+  const std::vector<BinaryTraceColumn> &columns = in.GetColumns ();
+  while (in.NextChunk ())
+    {
+      for (uint32_t r = 0; r < in.GetRows (); ++r)
+        {
+          out << in.GetUint (0, r) / 1e9;
+          for (size_t c = 1; c < columns.size (); ++c)
+            {
+              out << "\t";
+              if (columns[c].type == BinaryTraceColumn::F64)
+                {
+                  out << in.GetDouble (c, r);
+                }
+              else
+                {
+                  out << in.GetUint (c, r);
+                }
+            }
+          out << "\n";
+        }
+    }
+}
+
+/**
+ * Convert the reports of one analyzer of a SpectrumAnalyzer table to
+ * "time frequency psd" lines, with a blank line after every report.
+ */
+static void
+ConvertSpectrumTable (BinaryTraceReader &in, std::ostream &out, uint32_t analyzer)
+{
+  int time = in.FindColumn ("time");
+  int index = in.FindColumn ("analyzer");
+  // the PSD columns are named psd@<fc>
+  const std::vector<BinaryTraceColumn> &columns = in.GetColumns ();
+  std::vector<std::pair<size_t, double> > bands;
+  for (size_t c = 0; c < columns.size (); ++c)
+    {
+      if (columns[c].name.compare (0, 4, "psd@") == 0)
+        {
+          bands.push_back (std::make_pair (c, std::atof (columns[c].name.c_str () + 4)));
+        }
+    }
+  while (in.NextChunk ())
+    {
+      for (uint32_t r = 0; r < in.GetRows (); ++r)
+        {
+          if (in.GetUint (index, r) != analyzer)
+            {
+              continue;
+            }
+          double t = in.GetUint (time, r) / 1e9;
+          for (size_t b = 0; b < bands.size (); ++b)
+            {
+              out << t << " " << bands[b].second << " " << in.GetDouble (bands[b].first, r) << "\n";
+            }
+          out << "\n";
+        }
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  double startTime = 0.0;
+  double epochDuration = 0.25;
+  uint32_t analyzer = 0;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("input", "Binary trace file to convert, decompressed with zstd if it ends in .zst", input);
+  cmd.AddValue ("output", "Text file to write, default: the stats calculator file name", output);
+  cmd.AddValue ("startTime", "Start of the first RLC/PDCP epoch [s]", startTime);
+  cmd.AddValue ("epochDuration", "Duration of the RLC/PDCP epochs [s]", epochDuration);
+  cmd.AddValue ("analyzer", "Index of the spectrum analyzer to convert", analyzer);
+  cmd.Parse (argc, argv);
+
+  BinaryTraceReader in (input);
+  if (!in.IsOk ())
+    {
+      NS_FATAL_ERROR ("Can't read binary trace " << input);
+    }
+  const std::string &table = in.GetTable ();
+  if (output.empty ())
+    {
+      output = table + "Stats.txt";
+    }
+  std::ofstream out (output.c_str ());
+  if (!out.is_open ())
+    {
+      NS_FATAL_ERROR ("Can't open file " << output);
+    }
+
+  if (table == "DlRsrpSinr")
+    {
+      ConvertRowTable (in, out, "% time\tcellId\tIMSI\tRNTI\trsrp\tsinr\tComponentCarrierId");
+    }
+  else if (table == "UlSinr")
+    {
+      ConvertRowTable (in, out, "% time\tcellId\tIMSI\tRNTI\tsinrLinear\tcomponentCarrierId");
+    }
+  else if (table == "UlInterference")
+    {
+      ConvertInterferenceTable (in, out);
+    }
+  else if (table == "DlMac")
+    {
+      ConvertRowTable (in, out, "% time\tcellId\tIMSI\tframe\tsframe\tRNTI\tmcsTb1\tsizeTb1\tmcsTb2\tsizeTb2\tccId");
+    }
+  else if (table == "UlMac")
+    {
+      ConvertRowTable (in, out, "% time\tcellId\tIMSI\tframe\tsframe\tRNTI\tmcs\tsize\tccId");
+    }
+  else if (table == "DlRlc" || table == "UlRlc" || table == "DlPdcp" || table == "UlPdcp")
+    {
+      ConvertBearerTable (in, out, startTime, epochDuration);
+    }
+  else if (table == "SpectrumAnalyzer")
+    {
+      ConvertSpectrumTable (in, out, analyzer);
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown binary trace table " << table);
+    }
+  return 0;
+}
@@ -2,7 +2,8 @@
 #include <ns3/network-module.h>
 #include <ns3/mobility-module.h>
 #include <ns3/lte-module.h>
-#include <fstream>
+
+#include "lte-phy-stats-sink.h"
 
 using namespace ns3;
 
@@ -66,8 +67,9 @@ int main (int argc, char *argv[])
 
 
 
-  //enables traces to get SNR values and other values, outputs to different text files
-  lteHelper->EnablePhyTraces ();
+  // collects the SNR and interference values in memory, no text files needed
+  Ptr<LtePhyStatsSink> phyStats = Create<LtePhyStatsSink> ();
+  phyStats->Install (enbDevs, ueDevs);
   lteHelper->EnableRlcTraces ();
   Ptr<RadioBearerStatsCalculator> rlcStats = lteHelper->GetRlcStats ();
   rlcStats->SetAttribute ("StartTime", TimeValue (Seconds (0)));
@@ -80,36 +82,29 @@ int main (int argc, char *argv[])
 
 
 // getting the SNR vals
-  std::string a;
-  std::ifstream infile;
-  infile.open("DlRsrpSinrStats.txt");//open the text file for DownLink data
-
-    for (int i = 0; i < 14; i++) // get the 6th column value in the file to get SNR val in Downlink
-    {
-        infile >> a;  
-
-    }
-    std::cout << "SNR for DL: " << a << std::endl;
-    infile.close();
+  for (int i = 0; i < count; i++)
+  {
+    uint64_t imsi = ueDevs.Get (i)->GetObject<LteUeNetDevice> ()->GetImsi ();
+    uint16_t cellId = enbDevs.Get (i)->GetObject<LteEnbNetDevice> ()->GetCellId ();
+    PhyStatsSummary dl = phyStats->GetDlSinr (imsi, cellId);
+    PhyStatsSummary ul = phyStats->GetUlSinr (imsi, cellId);
+    std::cout << "IMSI " << imsi << " cell " << cellId
+              << " SNR for DL: " << dl.Mean () << " (" << dl.count << " samples)"
+              << " SNR for UL: " << ul.Mean () << " (" << ul.count << " samples)" << std::endl;
+  }
 
-    infile.open("UlSinrStats.txt");
-    for(int i = 0; i < 12; i++) // get the 5th column value in the file to get the SNR val in Uplink
+  // get the interferance vals
+  for (int i = 0; i < count; i++)
+  {
+    uint16_t cellId = enbDevs.Get (i)->GetObject<LteEnbNetDevice> ()->GetCellId ();
+    std::cout << "Interferance cell " << cellId << ":";
+    std::vector<double> perRb = phyStats->GetUlInterferencePerRb (cellId);
+    for (size_t rb = 0; rb < perRb.size (); rb++)
     {
-        infile >> a;
-    
+      std::cout << " " << perRb[rb];
     }
-     std::cout << "SNR for UL: " << a << std::endl;
-
-     infile.close();
-
-     // get the interferance vals
-
-     infile.open("UlInterferenceStats.txt");
-     for(int i = 0; i < count+1; i++)
-     {
-         std::getline(infile, a,'\n');
-         std::cout << "Interferance: " << a << std::endl;
-     }
+    std::cout << std::endl;
+  }
 
 
 
@@ -0,0 +1,213 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef REPLICATION_STATS_H
+#define REPLICATION_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Regularized incomplete beta function I_x (a, b), evaluated with the
+ * continued fraction of Numerical Recipes (modified Lentz method).
+ */
+inline double
+GetIncompleteBeta (double x, double a, double b)
+{
+  if (x <= 0)
+    {
+      return 0.0;
+    }
+  if (x >= 1)
+    {
+      return 1.0;
+    }
+  // the continued fraction converges fast for x < (a + 1) / (a + b + 2)
+  if (x > (a + 1) / (a + b + 2))
+    {
+      return 1.0 - GetIncompleteBeta (1 - x, b, a);
+    }
+  const double tiny = 1e-300;
+  double front = std::exp (std::lgamma (a + b) - std::lgamma (a) - std::lgamma (b)
+                           + a * std::log (x) + b * std::log (1 - x)) / a;
+  double f = 1;
+  double c = 1;
+  double d = 0;
+  for (int i = 0; i <= 400; ++i)
+    {
+      int m = i / 2;
+      double numerator;
+      if (i == 0)
+        {
+          numerator = 1;
+        }
+      else if (i % 2 == 0)
+        {
+          numerator = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+        }
+      else
+        {
+          numerator = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+        }
+      d = 1 + numerator * d;
+      d = std::fabs (d) < tiny ? tiny : d;
+      d = 1 / d;
+      c = 1 + numerator / c;
+      c = std::fabs (c) < tiny ? tiny : c;
+      f *= c * d;
+      if (std::fabs (1 - c * d) < 1e-12)
+        {
+          break;
+        }
+    }
+  return front * (f - 1);
+}
+
+/// Cumulative distribution function of Student's t with dof degrees of freedom
+inline double
+GetStudentTCdf (double t, double dof)
+{
+  double tail = 0.5 * GetIncompleteBeta (dof / (dof + t * t), dof / 2, 0.5);
+  return t >= 0 ? 1 - tail : tail;
+}
+
+/// Quantile p (0 to 1) of Student's t with dof degrees of freedom
+inline double
+GetStudentTQuantile (double p, double dof)
+{
+  if (p < 0.5)
+    {
+      return -GetStudentTQuantile (1 - p, dof);
+    }
+  double lo = 0;
+  double hi = 1;
+  while (GetStudentTCdf (hi, dof) < p && hi < 1e12)
+    {
+      hi *= 2;
+    }
+  for (int i = 0; i < 100 && hi - lo > 1e-10 * hi; ++i)
+    {
+      double mid = (lo + hi) / 2;
+      (GetStudentTCdf (mid, dof) < p ? lo : hi) = mid;
+    }
+  return (lo + hi) / 2;
+}
+
+/**
+ * Mean, standard deviation and Student-t confidence interval of a sample
+ * of independent replications, accumulated with Welford's method.
+ */
+class SampleStats
+{
+public:
+  SampleStats ()
+    : m_n (0),
+      m_mean (0),
+      m_m2 (0)
+  {
+  }
+
+  void Add (double x)
+  {
+    ++m_n;
+    double delta = x - m_mean;
+    m_mean += delta / m_n;
+    m_m2 += delta * (x - m_mean);
+  }
+
+  uint32_t GetN () const
+  {
+    return m_n;
+  }
+
+  double GetMean () const
+  {
+    return m_mean;
+  }
+
+  /// \return the sample standard deviation, 0 with fewer than two values
+  double GetStdDev () const
+  {
+    return m_n > 1 ? std::sqrt (m_m2 / (m_n - 1)) : 0.0;
+  }
+
+  /**
+   * \return the half width of the two-sided confidence interval of the
+   * mean at level confidence (e.g. 0.95), infinite with fewer than two values
+   */
+  double GetCiHalfWidth (double confidence) const
+  {
+    if (m_n < 2)
+      {
+        return std::numeric_limits<double>::infinity ();
+      }
+    return GetStudentTQuantile ((1 + confidence) / 2, m_n - 1) * GetStdDev () / std::sqrt (m_n);
+  }
+
+private:
+  uint32_t m_n;
+  double m_mean;
+  double m_m2; ///< sum of squared deviations from the mean
+};
+
+/**
+ * Truncation point of the warm-up transient of series by the MSER-m rule
+ * (MSER-5 for m = 5): the observations are averaged in batches of m and
+ * the first d batches are dropped, with d chosen among the first half of
+ * the batches to minimise the marginal standard error
+ * sum_{i >= d} (Y_i - mean_d)^2 / (k - d)^2 of the k - d batches kept.
+ * \return the number of observations to drop, a multiple of m
+ */
+inline size_t
+GetMserTruncation (const std::vector<double> &series, size_t m = 5)
+{
+  size_t k = series.size () / m;
+  if (k < 2)
+    {
+      return 0;
+    }
+  std::vector<double> batches (k, 0.0);
+  for (size_t i = 0; i < k * m; ++i)
+    {
+      batches[i / m] += series[i] / m;
+    }
+  // sums of the kept batches, from the end, so every d costs O (1)
+  double sum = 0;
+  double sumSquares = 0;
+  double best = std::numeric_limits<double>::infinity ();
+  size_t bestD = 0;
+  for (size_t d = k; d-- > 0; )
+    {
+      sum += batches[d];
+      sumSquares += batches[d] * batches[d];
+      double n = k - d;
+      double mser = std::max (sumSquares - sum * sum / n, 0.0) / (n * n);
+      // ties go to the shorter truncation
+      if (d <= k / 2 && mser <= best)
+        {
+          best = mser;
+          bestD = d;
+        }
+    }
+  return bestD * m;
+}
+
+#endif /* REPLICATION_STATS_H */
@@ -0,0 +1,223 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <ns3/core-module.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+/**
+ * Directory of memoized simulation results.
+ *
+ * A result is stored under a hash of the scenario, a canonical text the
+ * caller builds from its parameters (including the seed and run), and of
+ * the environment of the process: the default value of every attribute
+ * of every registered TypeId, which covers Config::SetDefault, the
+ * --ns3::Type::Attribute command line values and the ConfigStore, every
+ * global value but RngRun, and the version of the binary, identified by
+ * the path, size and modification time of the executable and of every
+ * shared library it maps.  A run whose key is in the store can return the
+ * stored result instead of simulating.
+ *
+ * Every result is one file, <dir>/<hash>.result, holding the scenario
+ * text so that a hash collision is a miss rather than a wrong result.
+ * Files are written aside and renamed, so concurrent runs and team
+ * members sharing the directory never see a partial result.
+ */
+class ResultStore
+{
+public:
+  /// \param dir directory of the store, created if needed; empty disables the store
+  explicit ResultStore (const std::string &dir = "")
+    : m_dir (dir)
+  {
+    if (!m_dir.empty ())
+      {
+        mkdir (m_dir.c_str (), 0755);
+      }
+  }
+
+  bool IsEnabled () const
+  {
+    return !m_dir.empty ();
+  }
+
+  /**
+   * \return the key of scenario, a single line of text, in the environment
+   * of the first call: keys must only be needed once the defaults are final
+   */
+  std::string GetKey (const std::string &scenario) const
+  {
+    if (m_environment.empty ())
+      {
+        m_environment = GetEnvironment ();
+      }
+    std::ostringstream key;
+    key << std::hex << Hash (scenario + "\n" + m_environment);
+    return key.str ();
+  }
+
+  /**
+   * Look scenario up
+   * \param result set to the stored result on a hit
+   * \return true on a hit
+   */
+  bool Lookup (const std::string &scenario, std::string &result) const
+  {
+    if (!IsEnabled ())
+      {
+        return false;
+      }
+    std::ifstream in (GetFile (scenario).c_str ());
+    std::string stored;
+    if (!std::getline (in, stored) || stored != scenario)
+      {
+        return false;
+      }
+    result.assign (std::istreambuf_iterator<char> (in), std::istreambuf_iterator<char> ());
+    return true;
+  }
+
+  /// Store result as the result of scenario
+  void Store (const std::string &scenario, const std::string &result) const
+  {
+    if (!IsEnabled ())
+      {
+        return;
+      }
+    std::string file = GetFile (scenario);
+    std::ostringstream tmp;
+    tmp << file << "." << getpid () << ".tmp";
+    std::ofstream out (tmp.str ().c_str (), std::ios_base::out | std::ios_base::trunc);
+    out << scenario << "\n" << result;
+    out.close ();
+    if (out)
+      {
+        std::rename (tmp.str ().c_str (), file.c_str ());
+      }
+    else
+      {
+        std::remove (tmp.str ().c_str ());
+      }
+  }
+
+  /**
+   * \return the canonical description of the attribute defaults, the
+   * global values and the binary version of this process
+   */
+  static std::string GetEnvironment ()
+  {
+    std::ostringstream os;
+    os.precision (17);
+    for (uint32_t i = 0; i < TypeId::GetRegisteredN (); ++i)
+      {
+        TypeId tid = TypeId::GetRegistered (i);
+        for (std::size_t j = 0; j < tid.GetAttributeN (); ++j)
+          {
+            struct TypeId::AttributeInformation info = tid.GetAttribute (j);
+            std::string type = info.checker->GetValueTypeName ();
+            // object pointers serialize to their address, which changes from run to run
+            if (type == "ns3::PointerValue" || type == "ns3::ObjectPtrContainerValue"
+                || type == "ns3::CallbackValue")
+              {
+                continue;
+              }
+            os << tid.GetName () << "::" << info.name << "="
+               << info.initialValue->SerializeToString (info.checker) << ";";
+          }
+      }
+    for (GlobalValue::Iterator it = GlobalValue::Begin (); it != GlobalValue::End (); ++it)
+      {
+        // the run is part of the scenario, so that replications can be looked up before they start
+        if ((*it)->GetName () == "RngRun")
+          {
+            continue;
+          }
+        StringValue value;
+        (*it)->GetValue (value);
+        os << (*it)->GetName () << "=" << value.Get () << ";";
+      }
+    os << GetBinaryVersion ();
+    return os.str ();
+  }
+
+private:
+  std::string GetFile (const std::string &scenario) const
+  {
+    return m_dir + "/" + GetKey (scenario) + ".result";
+  }
+
+  /// \return path, size and modification time of every executable file mapped by this process
+  static std::string GetBinaryVersion ()
+  {
+    std::ifstream maps ("/proc/self/maps");
+    std::set<std::string> files;
+    std::string line;
+    while (std::getline (maps, line))
+      {
+        std::istringstream fields (line);
+        std::string range, perms, offset, dev, inode, path;
+        fields >> range >> perms >> offset >> dev >> inode >> path;
+        if (perms.find ('x') != std::string::npos && !path.empty () && path[0] == '/')
+          {
+            files.insert (path);
+          }
+      }
+    std::ostringstream os;
+    for (std::set<std::string>::const_iterator it = files.begin (); it != files.end (); ++it)
+      {
+        struct stat st;
+        if (stat (it->c_str (), &st) == 0)
+          {
+            os << *it << " " << st.st_size << " " << st.st_mtime << ";";
+          }
+      }
+    return os.str ();
+  }
+
+  /// FNV-1a
+  static uint64_t Hash (const std::string &s)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < s.size (); ++i)
+      {
+        hash ^= static_cast<unsigned char> (s[i]);
+        hash *= 1099511628211ULL;
+      }
+    return hash;
+  }
+
+  std::string m_dir;
+  mutable std::string m_environment; ///< GetEnvironment () of the first key
+};
+
+} // namespace ns3
+
+#endif /* RESULT_STORE_H */
@@ -0,0 +1,224 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef SIM_PROCESS_POOL_H
+#define SIM_PROCESS_POOL_H
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Bounded pool of worker processes for running independent simulations.
+ *
+ * The ns-3 simulator is a process-wide singleton, so independent runs are
+ * parallelised with fork() rather than threads.  Each job runs in its own
+ * child process and writes its results as text to the stream it is given;
+ * the parent collects that text through a pipe.  At most maxWorkers
+ * children are alive at any time.  Children inherit the parent's
+ * simulation state as it is when Run () is called: call it before building
+ * anything for fresh runs, or after the setup to fan out from a shared one.
+ */
+class SimProcessPool
+{
+public:
+  /// Work executed in the child process; results go to the stream
+  typedef std::function<void (std::ostream &)> Job;
+
+  /// Outcome of one job, in submission order
+  struct JobResult
+  {
+    JobResult ()
+      : status (-1)
+    {
+    }
+    std::string output; ///< everything the job wrote to its stream
+    int status;         ///< exit status as returned by waitpid (), -1 if the job was not waited for
+    bool Ok () const
+    {
+      return WIFEXITED (status) && WEXITSTATUS (status) == 0;
+    }
+  };
+
+  /**
+   * \param maxWorkers maximum number of concurrent children; 0 means one
+   *        per online CPU
+   */
+  explicit SimProcessPool (unsigned maxWorkers = 0)
+    : m_maxWorkers (maxWorkers)
+  {
+    if (m_maxWorkers == 0)
+      {
+        long n = sysconf (_SC_NPROCESSORS_ONLN);
+        m_maxWorkers = n > 0 ? static_cast<unsigned> (n) : 1;
+      }
+  }
+
+  /// Queue a job; nothing runs until Run () is called
+  void Submit (Job job)
+  {
+    m_jobs.push_back (job);
+  }
+
+  unsigned GetMaxWorkers () const
+  {
+    return m_maxWorkers;
+  }
+
+  /**
+   * Run every queued job and wait for all of them to finish.
+   * \return one result per job, in submission order
+   */
+  std::vector<JobResult> Run ()
+  {
+    std::vector<JobResult> results (m_jobs.size ());
+    std::map<int, Worker> running; // keyed by read end of the pipe
+    size_t next = 0;
+
+    std::cout.flush ();
+    std::cerr.flush ();
+    while (next < m_jobs.size () || !running.empty ())
+      {
+        while (next < m_jobs.size () && running.size () < m_maxWorkers)
+          {
+            Worker w = Spawn (next);
+            running[w.fd] = w;
+            ++next;
+          }
+
+        std::vector<struct pollfd> fds;
+        for (std::map<int, Worker>::iterator it = running.begin (); it != running.end (); ++it)
+          {
+            struct pollfd p;
+            p.fd = it->first;
+            p.events = POLLIN;
+            p.revents = 0;
+            fds.push_back (p);
+          }
+        if (poll (&fds[0], fds.size (), -1) < 0)
+          {
+            if (errno == EINTR)
+              {
+                continue;
+              }
+            std::cerr << "SimProcessPool: poll failed: " << std::strerror (errno) << std::endl;
+            break;
+          }
+
+        for (size_t i = 0; i < fds.size (); ++i)
+          {
+            if (fds[i].revents == 0)
+              {
+                continue;
+              }
+            Worker &w = running[fds[i].fd];
+            char buf[4096];
+            ssize_t n = read (w.fd, buf, sizeof (buf));
+            if (n > 0)
+              {
+                results[w.job].output.append (buf, n);
+                continue;
+              }
+            if (n < 0 && errno == EINTR)
+              {
+                continue;
+              }
+            // EOF (or a broken pipe): the child is done with its output
+            close (w.fd);
+            int status = 0;
+            waitpid (w.pid, &status, 0);
+            results[w.job].status = status;
+            running.erase (fds[i].fd);
+          }
+      }
+    m_jobs.clear ();
+    return results;
+  }
+
+private:
+  struct Worker
+  {
+    pid_t pid;
+    int fd;
+    size_t job;
+  };
+
+  Worker Spawn (size_t job)
+  {
+    int p[2];
+    if (pipe (p) != 0)
+      {
+        std::cerr << "SimProcessPool: pipe failed: " << std::strerror (errno) << std::endl;
+        _exit (1);
+      }
+    pid_t pid = fork ();
+    if (pid < 0)
+      {
+        std::cerr << "SimProcessPool: fork failed: " << std::strerror (errno) << std::endl;
+        _exit (1);
+      }
+    if (pid == 0)
+      {
+        close (p[0]);
+        std::ostringstream os;
+        m_jobs[job] (os);
+        std::string out = os.str ();
+        const char *data = out.data ();
+        size_t left = out.size ();
+        while (left > 0)
+          {
+            ssize_t n = write (p[1], data, left);
+            if (n < 0)
+              {
+                if (errno == EINTR)
+                  {
+                    continue;
+                  }
+                _exit (1);
+              }
+            data += n;
+            left -= n;
+          }
+        close (p[1]);
+        std::cout.flush ();
+        // skip static destructors: they belong to the parent
+        _exit (0);
+      }
+    close (p[1]);
+    Worker w;
+    w.pid = pid;
+    w.fd = p[0];
+    w.job = job;
+    return w;
+  }
+
+  unsigned m_maxWorkers;
+  std::vector<Job> m_jobs;
+};
+
+#endif /* SIM_PROCESS_POOL_H */
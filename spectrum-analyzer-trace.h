@@ -0,0 +1,181 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef SPECTRUM_ANALYZER_TRACE_H
+#define SPECTRUM_ANALYZER_TRACE_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/spectrum-module.h>
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "binary-trace-format.h"
+
+namespace ns3 {
+
+/**
+ * Decimating sink for the AveragePowerSpectralDensityReport trace of
+ * spectrum analyzers.
+ *
+ * A spectrum analyzer already averages the received power over each
+ * Resolution interval, so averaging over a slot or a subframe is done by
+ * setting Resolution to that period, which also saves the events of the
+ * shorter reports.  Without averaging, the analyzer keeps a short
+ * Resolution and this sink samples it: only the first report of every
+ * period is kept.
+ *
+ * In binary mode the reports of all the analyzers go to one table
+ * (see binary-trace-format.h) with one row per report: the time in ns,
+ * the analyzer index and one PSD column per band, named "psd@<fc>" with
+ * the band center frequency in Hz.  lte-trace-convert writes it back in
+ * the text layout of SpectrumAnalyzerHelper::EnableAsciiAll.  In text
+ * mode every analyzer gets that layout directly, in
+ * <prefix>-<node>-<device>.tr, written by a background thread.
+ */
+class SpectrumAnalyzerTrace : public SimpleRefCount<SpectrumAnalyzerTrace>
+{
+public:
+  /**
+   * \param filename binary table, or prefix of the text files
+   * \param sm spectrum model of the analyzers
+   * \param samplePeriod keep one report per period; zero keeps every report
+   * \param binary write one binary table instead of a text file per analyzer
+   */
+  SpectrumAnalyzerTrace (const std::string &filename, Ptr<const SpectrumModel> sm,
+                         Time samplePeriod = Time (0), bool binary = true)
+    : m_filename (filename),
+      m_samplePeriod (samplePeriod.GetNanoSeconds ()),
+      m_binary (binary)
+  {
+    for (Bands::const_iterator it = sm->Begin (); it != sm->End (); ++it)
+      {
+        m_frequencies.push_back (it->fc);
+      }
+    if (m_binary)
+      {
+        typedef BinaryTraceColumn C;
+        std::vector<C> c;
+        c.push_back (C ("time", C::U64));
+        c.push_back (C ("analyzer", C::U16));
+        for (size_t b = 0; b < m_frequencies.size (); ++b)
+          {
+            std::ostringstream name;
+            name.precision (15);
+            name << "psd@" << m_frequencies[b];
+            c.push_back (C (name.str (), C::F64));
+          }
+        m_table.reset (new BinaryTraceWriter (filename, "SpectrumAnalyzer", c, 512));
+      }
+  }
+
+  ~SpectrumAnalyzerTrace ()
+  {
+    Close ();
+  }
+
+  /// Connect to the analyzers of analyzerDevs, as installed by SpectrumAnalyzerHelper
+  void Install (NetDeviceContainer analyzerDevs)
+  {
+    for (uint32_t i = 0; i < analyzerDevs.GetN (); ++i)
+      {
+        Ptr<NetDevice> dev = analyzerDevs.Get (i);
+        uint16_t analyzer = m_nextReport.size ();
+        m_nextReport.push_back (0);
+        if (!m_binary)
+          {
+            std::ostringstream name;
+            name << m_filename << "-" << dev->GetNode ()->GetId () << "-" << dev->GetIfIndex () << ".tr";
+            m_text.push_back (std::make_shared<AsyncTraceFile> (name.str ()));
+            m_textBuffers.push_back (std::vector<uint8_t> ());
+          }
+        dev->GetObject<NonCommunicatingNetDevice> ()->GetPhy ()->TraceConnectWithoutContext (
+          "AveragePowerSpectralDensityReport",
+          MakeBoundCallback (&SpectrumAnalyzerTrace::Report, this, analyzer));
+      }
+  }
+
+  /// Flush and close the output; called automatically on destruction
+  void Close ()
+  {
+    if (m_table)
+      {
+        m_table->Close ();
+      }
+    for (size_t i = 0; i < m_text.size (); ++i)
+      {
+        m_text[i]->Write (m_textBuffers[i]);
+        m_text[i]->Close ();
+      }
+  }
+
+private:
+  static void Report (SpectrumAnalyzerTrace *t, uint16_t analyzer, Ptr<const SpectrumValue> psd)
+  {
+    int64_t now = Simulator::Now ().GetNanoSeconds ();
+    if (now < t->m_nextReport[analyzer])
+      {
+        return;
+      }
+    if (t->m_samplePeriod > 0)
+      {
+        t->m_nextReport[analyzer] = (now / t->m_samplePeriod + 1) * t->m_samplePeriod;
+      }
+    if (t->m_binary)
+      {
+        t->m_table->Add (now).Add (analyzer);
+        for (size_t b = 0; b < psd->GetValuesN (); ++b)
+          {
+            t->m_table->Add ((*psd)[b]);
+          }
+        t->m_table->EndRow ();
+        return;
+      }
+    // same layout as SpectrumAnalyzerHelper's ASCII output
+    std::vector<uint8_t> &out = t->m_textBuffers[analyzer];
+    char line[96];
+    for (size_t b = 0; b < psd->GetValuesN (); ++b)
+      {
+        int n = std::snprintf (line, sizeof (line), "%.6g %.6g %.6g\n",
+                               now / 1e9, t->m_frequencies[b], (*psd)[b]);
+        out.insert (out.end (), line, line + n);
+      }
+    out.push_back ('\n');
+    if (out.size () >= 64 * 1024)
+      {
+        t->m_text[analyzer]->Write (out);
+      }
+  }
+
+  std::string m_filename;
+  int64_t m_samplePeriod;             ///< in ns
+  bool m_binary;
+  std::vector<double> m_frequencies;  ///< band center frequencies
+  std::vector<int64_t> m_nextReport;  ///< time of the next report kept, per analyzer
+  std::unique_ptr<BinaryTraceWriter> m_table;
+  std::vector<std::shared_ptr<AsyncTraceFile> > m_text;
+  std::vector<std::vector<uint8_t> > m_textBuffers;
+};
+
+} // namespace ns3
+
+#endif /* SPECTRUM_ANALYZER_TRACE_H */
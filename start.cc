@@ -28,6 +28,11 @@
 #include "ns3/lte-module.h"
 //#include "ns3/gtk-config-store.h"
  
+#include "goodput-monitor.h"
+#include "lte-binary-traces.h"
+#include "result-store.h"
+#include "steady-state-goodput.h"
+ 
 using namespace ns3;
 using namespace std;
  
@@ -40,6 +45,14 @@ main (int argc, char *argv[])
   double simTime = 1.5;
   double distance = 1000.0;
   Time interPacketInterval = MilliSeconds (1);
+  bool enableTraces = true;
+  bool binaryTraces = false;
+  bool compressTraces = false;
+  Time goodputWindow = Seconds (0);
+  string goodputOutput = "goodput-series.csv";
+  bool warmupDetection = false;
+  Time warmupWindow = MilliSeconds (50);
+  string resultStoreDir;
  
   // Command line arguments
   CommandLine cmd (__FILE__);
@@ -47,6 +60,17 @@ main (int argc, char *argv[])
   cmd.AddValue ("simTime", "Total duration of the simulation", simTime);
   cmd.AddValue ("distance", "Distance between eNBs [m]", distance);
   cmd.AddValue ("interPacketInterval", "Inter packet interval", interPacketInterval);
+  cmd.AddValue ("traces", "Enable the LTE stats traces", enableTraces);
+  cmd.AddValue ("binaryTraces", "Write the LTE traces in binary columnar format", binaryTraces);
+  cmd.AddValue ("compressTraces", "Compress the binary traces with zstd", compressTraces);
+  cmd.AddValue ("goodputWindow", "Window of the per-flow goodput series, 0 disables it", goodputWindow);
+  cmd.AddValue ("goodputOutput", "CSV file receiving the goodput series", goodputOutput);
+  cmd.AddValue ("warmupDetection", "Detect the warm-up of every flow with MSER-5 and measure "
+                "its goodput from there instead of from 0.5 s", warmupDetection);
+  cmd.AddValue ("warmupWindow", "Window of the throughput series of the warm-up detection", warmupWindow);
+  cmd.AddValue ("resultStore", "Directory of memoized results: a run whose parameters, defaults and "
+                "binary are unchanged prints the stored goodputs without simulating; only used without traces "
+                "and goodput series, whose files a stored result would not write", resultStoreDir);
   cmd.Parse (argc, argv);
  
   ConfigStore inputConfig;
@@ -54,6 +78,20 @@ main (int argc, char *argv[])
  
   // parse again so you can override default values from the command line
   cmd.Parse(argc, argv);
+
+  ResultStore store (enableTraces || goodputWindow.IsStrictlyPositive () ? "" : resultStoreDir);
+  ostringstream scenario;
+  scenario.precision (17);
+  scenario << "start numNodePairs=" << numNodePairs << " simTime=" << simTime << " distance=" << distance
+           << " interPacketInterval=" << interPacketInterval.GetTimeStep ()
+           << " warmupDetection=" << warmupDetection << " warmupWindow=" << warmupWindow.GetTimeStep ()
+           << " run=" << RngSeedManager::GetRun ();
+  string stored;
+  if (store.Lookup (scenario.str (), stored))
+    {
+      cout << stored;
+      return 0;
+    }
  
   Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
   Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper> ();
@@ -150,7 +188,40 @@ main (int argc, char *argv[])
  
   serverApps.Start (MilliSeconds (500));
   clientApps.Start (MilliSeconds (500));
-  lteHelper->EnableTraces ();
+
+  Ptr<GoodputMonitor> goodputMonitor;
+  if (goodputWindow.IsStrictlyPositive ())
+    {
+      // UE u is attached to eNB u and sends the only flow of its cell
+      goodputMonitor = Create<GoodputMonitor> (goodputOutput, goodputWindow, MilliSeconds (500));
+      for (uint32_t u = 0; u < serverApps.GetN (); ++u)
+        {
+          goodputMonitor->AddFlow (serverApps.Get (u), u, "Ue", 0);
+        }
+      goodputMonitor->Start (Seconds (simTime));
+    }
+
+  Ptr<SteadyStateGoodput> steadyState;
+  if (warmupDetection)
+    {
+      steadyState = Create<SteadyStateGoodput> (warmupWindow, MilliSeconds (500));
+      for (uint32_t u = 0; u < serverApps.GetN (); ++u)
+        {
+          steadyState->AddFlow (serverApps.Get (u));
+        }
+      steadyState->Start (Seconds (simTime));
+    }
+
+  Ptr<LteBinaryTraceHelper> binaryTraceHelper;
+  if (enableTraces && binaryTraces)
+    {
+      binaryTraceHelper = Create<LteBinaryTraceHelper> ("", compressTraces);
+      binaryTraceHelper->Install (enbLteDevs, ueLteDevs);
+    }
+  else if (enableTraces)
+    {
+      lteHelper->EnableTraces ();
+    }
   // Uncomment to enable PCAP tracing
   //p2ph.EnablePcapAll("lena-simple-epc");
  
@@ -161,10 +232,17 @@ main (int argc, char *argv[])
   config.ConfigureAttributes();*/
  
   Simulator::Destroy ();
+  ostringstream report;
     for (int j = 0; j < 2; ++j) {
         uint64_t sum = DynamicCast<PacketSink> (serverApps.Get(j))->GetTotalRx ();
-        double goodput = sum * 8 / (simTime - .5);
-        cout << "Node " << j << " packets: " << sum << " Goodput: " << goodput << "\n";
+        double goodput = steadyState ? steadyState->GetGoodput (j) : sum * 8 / (simTime - .5);
+        report << "Node " << j << " packets: " << sum << " Goodput: " << goodput;
+        if (steadyState) {
+          report << " (steady state from " << steadyState->GetWarmupEnd (j).GetSeconds () << " s)";
+        }
+        report << "\n";
     }
+  cout << report.str ();
+  store.Store (scenario.str (), report.str ());
   return 0;
 }
\ No newline at end of file
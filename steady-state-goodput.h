@@ -0,0 +1,147 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef STEADY_STATE_GOODPUT_H
+#define STEADY_STATE_GOODPUT_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/applications-module.h>
+
+#include <vector>
+
+#include "replication-stats.h"
+
+namespace ns3 {
+
+/**
+ * Per-flow goodput measured from the end of the warm-up transient.
+ *
+ * The bytes received by every monitored PacketSink are sampled at the
+ * end of every window, which gives one windowed throughput series per
+ * flow.  The warm-up of each flow, which covers RRC connection, CQI and
+ * closed loop power control settling, is detected on its series with
+ * MSER-5, and the goodput of the flow is measured over the windows after
+ * it only.  A partial window at the end of the run is left out, but the
+ * window ending at the stop time is kept.
+ */
+class SteadyStateGoodput : public SimpleRefCount<SteadyStateGoodput>
+{
+public:
+  /**
+   * \param window length of a window of the series
+   * \param start start of the first window, usually when the sinks start
+   */
+  SteadyStateGoodput (Time window, Time start)
+    : m_window (window),
+      m_start (start)
+  {
+    NS_ABORT_MSG_IF (!window.IsStrictlyPositive (), "the warm-up detection window must be positive");
+  }
+
+  /// Monitor the flow received by sink, a PacketSink; flows are numbered in order
+  void AddFlow (Ptr<Application> sink)
+  {
+    Flow f;
+    f.sink = DynamicCast<PacketSink> (sink);
+    f.lastBytes = 0;
+    m_flows.push_back (f);
+  }
+
+  /// Schedule the windows up to stop; call before Simulator::Run ()
+  void Start (Time stop)
+  {
+    m_stop = stop;
+    m_windowEnd = m_start + m_window;
+    ScheduleWindowEnd ();
+  }
+
+  /// \return the end of the warm-up of flow, the start of its measurement
+  Time GetWarmupEnd (size_t flow) const
+  {
+    return m_start + NanoSeconds (m_window.GetNanoSeconds () * static_cast<int64_t> (GetTruncation (flow)));
+  }
+
+  /// \return the goodput of flow after its warm-up [bit/s]
+  double GetGoodput (size_t flow) const
+  {
+    const std::vector<double> &series = m_flows[flow].series;
+    size_t d = GetTruncation (flow);
+    if (d >= series.size ())
+      {
+        return 0.0;
+      }
+    double sum = 0;
+    for (size_t i = d; i < series.size (); ++i)
+      {
+        sum += series[i];
+      }
+    return sum / (series.size () - d);
+  }
+
+private:
+  struct Flow
+  {
+    Ptr<PacketSink> sink;
+    uint64_t lastBytes;         ///< bytes received at the end of the last window
+    std::vector<double> series; ///< goodput of every window [bit/s]
+  };
+
+  size_t GetTruncation (size_t flow) const
+  {
+    return GetMserTruncation (m_flows[flow].series, 5);
+  }
+
+  /**
+   * Schedule the end of the window ending at m_windowEnd.  The Stop event
+   * of the run is scheduled first, so a window ending at the stop time is
+   * closed one time step early to run before it.
+   */
+  void ScheduleWindowEnd ()
+  {
+    Time delay = m_windowEnd - Simulator::Now ();
+    Simulator::Schedule (m_windowEnd < m_stop ? delay : delay - TimeStep (1), &SteadyStateGoodput::EndWindow, this);
+  }
+
+  void EndWindow ()
+  {
+    double windowSeconds = m_window.GetSeconds ();
+    for (size_t i = 0; i < m_flows.size (); ++i)
+      {
+        Flow &f = m_flows[i];
+        uint64_t bytes = f.sink->GetTotalRx ();
+        f.series.push_back ((bytes - f.lastBytes) * 8 / windowSeconds);
+        f.lastBytes = bytes;
+      }
+    m_windowEnd += m_window;
+    if (m_windowEnd <= m_stop)
+      {
+        ScheduleWindowEnd ();
+      }
+  }
+
+  Time m_window;
+  Time m_start;
+  Time m_stop;
+  Time m_windowEnd; ///< end of the current window
+  std::vector<Flow> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* STEADY_STATE_GOODPUT_H */
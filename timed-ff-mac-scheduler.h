@@ -0,0 +1,257 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Colton Mack, Ruth Pavoor
+ */
+
+#ifndef TIMED_FF_MAC_SCHEDULER_H
+#define TIMED_FF_MAC_SCHEDULER_H
+
+#include <ns3/core-module.h>
+#include <ns3/lte-module.h>
+
+#include <chrono>
+#include <string>
+
+namespace ns3 {
+
+/// CPU cost and allocations of the schedulers of a process
+struct SchedulerCost
+{
+  SchedulerCost ()
+    : dlTriggers (0),
+      dlAllocations (0),
+      ulAllocations (0),
+      seconds (0)
+  {
+  }
+
+  uint64_t dlTriggers;    ///< downlink scheduling calls, one per cell and TTI
+  uint64_t dlAllocations; ///< downlink data allocations (one per UE and TTI)
+  uint64_t ulAllocations; ///< uplink DCIs
+  double seconds;         ///< wall time spent inside the schedulers
+};
+
+/**
+ * FF MAC scheduler that forwards every call to a scheduler of type
+ * SchedulerType and measures it.
+ *
+ * The time of every scheduling SAP call is added to the cost of the
+ * process, without the time spent in the MAC callbacks that return the
+ * decisions, so the cost is that of the scheduler alone; the allocations
+ * are counted from those callbacks.  The cost is summed over all the
+ * instances of the process, which is the right scope when each run is a
+ * process of its own, as in the scenario sweeps.
+ *
+ * Use it with LteHelper::SetSchedulerType ("ns3::TimedFfMacScheduler")
+ * and set SchedulerType with SetSchedulerAttribute; UlCqiFilter is
+ * forwarded to the wrapped scheduler.
+ */
+class TimedFfMacScheduler : public FfMacScheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::TimedFfMacScheduler")
+      .SetParent<FfMacScheduler> ()
+      .AddConstructor<TimedFfMacScheduler> ()
+      .AddAttribute ("SchedulerType", "Type of the wrapped scheduler",
+                     StringValue ("ns3::PfFfMacScheduler"),
+                     MakeStringAccessor (&TimedFfMacScheduler::m_schedulerType),
+                     MakeStringChecker ())
+    ;
+    return tid;
+  }
+
+  TimedFfMacScheduler ()
+    : m_schedUser (0),
+      m_callbackSeconds (0)
+  {
+    m_schedProvider.m_owner = this;
+    m_schedUserProxy.m_owner = this;
+  }
+
+  /// \return the cost of all the instances of this process
+  static SchedulerCost &GetTotalCost ()
+  {
+    static SchedulerCost cost;
+    return cost;
+  }
+
+  virtual void SetFfMacCschedSapUser (FfMacCschedSapUser *s)
+  {
+    GetScheduler ()->SetFfMacCschedSapUser (s);
+  }
+
+  virtual void SetFfMacSchedSapUser (FfMacSchedSapUser *s)
+  {
+    m_schedUser = s;
+    GetScheduler ()->SetFfMacSchedSapUser (&m_schedUserProxy);
+  }
+
+  virtual FfMacCschedSapProvider *GetFfMacCschedSapProvider ()
+  {
+    return GetScheduler ()->GetFfMacCschedSapProvider ();
+  }
+
+  virtual FfMacSchedSapProvider *GetFfMacSchedSapProvider ()
+  {
+    return &m_schedProvider;
+  }
+
+  virtual void SetLteFfrSapProvider (LteFfrSapProvider *s)
+  {
+    GetScheduler ()->SetLteFfrSapProvider (s);
+  }
+
+  virtual LteFfrSapUser *GetLteFfrSapUser ()
+  {
+    return GetScheduler ()->GetLteFfrSapUser ();
+  }
+
+protected:
+  virtual void DoInitialize ()
+  {
+    GetScheduler ()->Initialize ();
+    FfMacScheduler::DoInitialize ();
+  }
+
+  virtual void DoDispose ()
+  {
+    if (m_scheduler)
+      {
+        m_scheduler->Dispose ();
+        m_scheduler = 0;
+      }
+    FfMacScheduler::DoDispose ();
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  static double GetSeconds (Clock::time_point start)
+  {
+    return std::chrono::duration<double> (Clock::now () - start).count ();
+  }
+
+  Ptr<FfMacScheduler> GetScheduler ()
+  {
+    if (!m_scheduler)
+      {
+        ObjectFactory factory;
+        factory.SetTypeId (m_schedulerType);
+        factory.Set ("UlCqiFilter", EnumValue (m_ulCqiFilter));
+        m_scheduler = factory.Create<FfMacScheduler> ();
+      }
+    return m_scheduler;
+  }
+
+  /// Call method of the wrapped provider and add its time to the cost
+  template <class P>
+  void Forward (void (FfMacSchedSapProvider::*method) (const P &), const P &params)
+  {
+    double callbackSeconds = m_callbackSeconds;
+    Clock::time_point start = Clock::now ();
+    (m_scheduler->GetFfMacSchedSapProvider ()->*method) (params);
+    GetTotalCost ().seconds += GetSeconds (start) - (m_callbackSeconds - callbackSeconds);
+  }
+
+  class SchedProvider : public FfMacSchedSapProvider
+  {
+  public:
+    virtual void SchedDlRlcBufferReq (const SchedDlRlcBufferReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedDlRlcBufferReq, params);
+    }
+    virtual void SchedDlPagingBufferReq (const SchedDlPagingBufferReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedDlPagingBufferReq, params);
+    }
+    virtual void SchedDlMacBufferReq (const SchedDlMacBufferReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedDlMacBufferReq, params);
+    }
+    virtual void SchedDlTriggerReq (const SchedDlTriggerReqParameters &params)
+    {
+      ++GetTotalCost ().dlTriggers;
+      m_owner->Forward (&FfMacSchedSapProvider::SchedDlTriggerReq, params);
+    }
+    virtual void SchedDlRachInfoReq (const SchedDlRachInfoReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedDlRachInfoReq, params);
+    }
+    virtual void SchedDlCqiInfoReq (const SchedDlCqiInfoReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedDlCqiInfoReq, params);
+    }
+    virtual void SchedUlTriggerReq (const SchedUlTriggerReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedUlTriggerReq, params);
+    }
+    virtual void SchedUlNoiseInterferenceReq (const SchedUlNoiseInterferenceReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedUlNoiseInterferenceReq, params);
+    }
+    virtual void SchedUlSrInfoReq (const SchedUlSrInfoReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedUlSrInfoReq, params);
+    }
+    virtual void SchedUlMacCtrlInfoReq (const SchedUlMacCtrlInfoReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedUlMacCtrlInfoReq, params);
+    }
+    virtual void SchedUlCqiInfoReq (const SchedUlCqiInfoReqParameters &params)
+    {
+      m_owner->Forward (&FfMacSchedSapProvider::SchedUlCqiInfoReq, params);
+    }
+
+    TimedFfMacScheduler *m_owner;
+  };
+
+  /// Counts the allocations and keeps the MAC time out of the scheduler cost
+  class SchedUserProxy : public FfMacSchedSapUser
+  {
+  public:
+    virtual void SchedDlConfigInd (const SchedDlConfigIndParameters &params)
+    {
+      GetTotalCost ().dlAllocations += params.m_buildDataList.size ();
+      Clock::time_point start = Clock::now ();
+      m_owner->m_schedUser->SchedDlConfigInd (params);
+      m_owner->m_callbackSeconds += GetSeconds (start);
+    }
+    virtual void SchedUlConfigInd (const SchedUlConfigIndParameters &params)
+    {
+      GetTotalCost ().ulAllocations += params.m_dciList.size ();
+      Clock::time_point start = Clock::now ();
+      m_owner->m_schedUser->SchedUlConfigInd (params);
+      m_owner->m_callbackSeconds += GetSeconds (start);
+    }
+
+    TimedFfMacScheduler *m_owner;
+  };
+
+  std::string m_schedulerType;
+  Ptr<FfMacScheduler> m_scheduler;
+  SchedProvider m_schedProvider;
+  SchedUserProxy m_schedUserProxy;
+  FfMacSchedSapUser *m_schedUser;
+  double m_callbackSeconds; ///< time spent in the MAC callbacks so far
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TimedFfMacScheduler);
+
+} // namespace ns3
+
+#endif /* TIMED_FF_MAC_SCHEDULER_H */